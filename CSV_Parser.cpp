@@ -6,12 +6,73 @@
     #include <SD.h>
 #endif
 
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+
 #ifdef NON_ARDUINO
     #include <stdlib.h>
     #include <string.h>
     #include <string>
     #include <stdio.h>
     #include <ctype.h>
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <sys/mman.h>
+    #include <thread>
+    #include <vector>
+    #include <chrono>
+#endif
+
+#if defined(CSV_PARSER_SIMD)
+  #if defined(__AVX2__) || defined(__SSE2__)
+    #include <immintrin.h>
+  #else
+    #include <arm_neon.h>
+  #endif
+
+/*  Computes bitmasks of structural characters within 64 bytes starting at p (bit i corresponds to p[i]):
+      delim_mask - delimiter, '\r' and '\n'
+      quote_mask - quote char  
+    parseStringValue then finds the ends of values by looking up set bits instead of comparing chars one by one.  */
+static inline void scanBlock(const char * p, char delimiter, char quote_char, uint64_t * delim_mask, uint64_t * quote_mask) {
+  uint64_t d_mask = 0, q_mask = 0;
+#if defined(__AVX2__)
+  const __m256i d = _mm256_set1_epi8(delimiter), cr = _mm256_set1_epi8('\r'), lf = _mm256_set1_epi8('\n'), q = _mm256_set1_epi8(quote_char);
+  for (int i = 0; i < 64; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+    __m256i delims = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, d), _mm256_cmpeq_epi8(v, cr)), _mm256_cmpeq_epi8(v, lf));
+    d_mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(delims) << i;
+    q_mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, q)) << i;
+  }
+#elif defined(__SSE2__)
+  const __m128i d = _mm_set1_epi8(delimiter), cr = _mm_set1_epi8('\r'), lf = _mm_set1_epi8('\n'), q = _mm_set1_epi8(quote_char);
+  for (int i = 0; i < 64; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+    __m128i delims = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, d), _mm_cmpeq_epi8(v, cr)), _mm_cmpeq_epi8(v, lf));
+    d_mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(delims) << i;
+    q_mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)) << i;
+  }
+#else
+  // NEON has no movemask instruction, bits are gathered by pairwise additions of masked comparison results
+  const uint8x16_t d = vdupq_n_u8(delimiter), cr = vdupq_n_u8('\r'), lf = vdupq_n_u8('\n'), q = vdupq_n_u8(quote_char);
+  const uint8x16_t bits = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+  uint8x16_t delims[4], quotes[4];
+  for (int i = 0; i < 4; i++) {
+    uint8x16_t v = vld1q_u8((const uint8_t*)p + i * 16);
+    delims[i] = vandq_u8(vorrq_u8(vorrq_u8(vceqq_u8(v, d), vceqq_u8(v, cr)), vceqq_u8(v, lf)), bits);
+    quotes[i] = vandq_u8(vceqq_u8(v, q), bits);
+  }
+  uint8x16_t sum = vpaddq_u8(vpaddq_u8(delims[0], delims[1]), vpaddq_u8(delims[2], delims[3]));
+  d_mask = vgetq_lane_u64(vreinterpretq_u64_u8(vpaddq_u8(sum, sum)), 0);
+  sum = vpaddq_u8(vpaddq_u8(quotes[0], quotes[1]), vpaddq_u8(quotes[2], quotes[3]));
+  q_mask = vgetq_lane_u64(vreinterpretq_u64_u8(vpaddq_u8(sum, sum)), 0);
+#endif
+  *delim_mask = d_mask;
+  *quote_mask = q_mask;
+}
 #endif
 
 // external function declaration for feeding characters to parser it must return a char
@@ -31,12 +92,14 @@ bool __attribute__((weak)) rowParserFinished() { return true; }
 
 /*  Helper function useful for handling unsigned format specifiers.   */
 char * CSV_Parser::strdup_ignoring_u(const char *s) {
-  char * new_s = (char *)malloc(strlen_ignoring_u(s) + 1);
+  char * new_s = (char *)allocMemory(strlen_ignoring_u(s) + 1);
+  if (!new_s)
+    return 0;
   char * ret = new_s;
   
   while (*s) {
     *new_s = *s++;
-    if (*new_s != 'u')
+    if (*new_s != 'u' && !isdigit(*new_s))
       new_s++;
   }
   *new_s = 0;
@@ -47,35 +110,284 @@ char * CSV_Parser::strdup_ignoring_u(const char *s) {
 /*  Helper function useful for handling unsigned format specifiers.   */
 size_t CSV_Parser::strlen_ignoring_u(const char *s) {
   size_t sz = 0;
-  while (*s)
-    sz += (*s++ != 'u');
+  for (; *s; s++)
+    sz += *s != 'u' && !isdigit(*s);
   return sz;
 }
 
-/*  Creates dynamically allocated copy of a string with leading and trailing space removed. 
+/*  Creates dynamically allocated copy of a value with leading and trailing space removed. 
 	Example input = "   test string    "
 	Example output = "test string"
 	
 	(it is used for saving header names)
 	*/
-char * CSV_Parser::strdup_trimmed(const char * s) {
-  s += strspn(s, " ");
+char * CSV_Parser::strdup_trimmed(const ParsedValue & val) {
+  char * new_s = (char*)allocMemory(val.len + 1);
+  if (!new_s)
+    return 0;
+  copyValue(new_s, val);
+  char * s = new_s + strspn(new_s, " ");
   int len = strlen(s);
-  while(isspace(s[len - 1])) 
+  while(len && isspace(s[len - 1])) 
     --len;
-  //return strndup(s, len); // unfortunately strndup is not available in Arduino
-  char * new_s = strdup(s);
+  memmove(new_s, s, len);
   new_s[len] = 0;
   return new_s;
 }
 
+/*  Copies value to dst (turning 2's of adjacent quote chars into 1's if value was enclosed in quote chars) and terminates it with 0.  */
+void CSV_Parser::copyValue(char * dst, const ParsedValue & val) {
+  const char * s = val.s;
+  if (!val.quoted) {
+    memcpy(dst, s, val.len);
+  } else {
+    for (int i = 0; i < val.len; i++) {
+      dst[i] = *s++;
+      if (*(s-1) == quote_char && *s == quote_char)
+        s += 1;
+    }
+  }
+  dst[val.len] = 0;
+}
+
+/*  Returns memory for a string of "len" chars (and terminating 0) from the strings arena.
+    Strings are copied one after another into slabs, so storing a string costs a single copy and
+    all of them are released by freeing a handful of slabs (instead of each string separately).  */
+char * CSV_Parser::allocString(size_t len) {
+  size_t size = len + 1;
+  if (!string_slabs || string_slabs->capacity - string_slabs->used < size) {
+    size_t capacity = size > CSV_PARSER_STRING_SLAB_SIZE ? size : CSV_PARSER_STRING_SLAB_SIZE;
+    if (pool) {
+      // slabs carved from a small pool are smaller than usual, so they don't take the memory needed by values arrays
+      size_t available = poolAvailable() > sizeof(StringSlab) ? poolAvailable() - sizeof(StringSlab) : 0;
+      if (capacity > available / 4)
+        capacity = size > available / 4 ? size : available / 4;
+    }
+    StringSlab * slab = (StringSlab*)allocMemory(sizeof(StringSlab) + capacity);
+    if (!slab)
+      return 0;
+    slab->used = 0;
+    slab->capacity = capacity;
+    if (string_slabs && capacity == size) {
+      // oversized string gets its own slab, placed behind the current one so the space left in the current one isn't wasted
+      slab->next = string_slabs->next;
+      string_slabs->next = slab;
+    } else {
+      slab->next = string_slabs;
+      string_slabs = slab;
+    }
+    slab->used = size;
+    return slab->data();
+  }
+  char * str = string_slabs->data() + string_slabs->used;
+  string_slabs->used += size;
+  return str;
+}
+
+/*  Releases all stored strings. If "keep_slab" is true then the most recent slab is kept (and reused) instead of being freed.  */
+void CSV_Parser::freeStrings(bool keep_slab) {
+  StringSlab * slab = string_slabs;
+  if (keep_slab && slab) {
+    slab->used = 0;
+    slab = slab->next;
+    string_slabs->next = 0;
+  } else {
+    string_slabs = 0;
+  }
+  while (slab) {
+    StringSlab * next = slab->next;
+    freeMemory(slab);
+    slab = next;
+  }
+  markRowStrings();
+}
+
+void CSV_Parser::markRowStrings() {
+  row_slab = string_slabs;
+  row_slab_next = string_slabs ? string_slabs->next : 0;
+  row_slab_used = string_slabs ? string_slabs->used : 0;
+}
+
+/*  All memory used by the parser is obtained through allocMemory, reallocMemory and freeMemory.
+    By default they use the heap. If a pool was supplied to the constructor then memory is carved from it instead:
+    each block is preceded by its size, blocks are placed one after another and only the last block can be resized 
+    in place or given back (other blocks are moved on resize and their old space isn't reused).  */
+#define CSV_PARSER_POOL_HEADER_SIZE ((sizeof(size_t) + CSV_PARSER_POOL_ALIGNMENT - 1) / CSV_PARSER_POOL_ALIGNMENT * CSV_PARSER_POOL_ALIGNMENT)
+
+static size_t alignPoolSize(size_t size) {
+  return (size + CSV_PARSER_POOL_ALIGNMENT - 1) / CSV_PARSER_POOL_ALIGNMENT * CSV_PARSER_POOL_ALIGNMENT;
+}
+
+void * CSV_Parser::allocMemory(size_t size) {
+#ifdef CSV_PARSER_ENABLE_STATS
+  stats.allocs++;
+  stats.allocated_bytes += size;
+  if (!pool) {
+    // the size is stored before the block (like in the pool), so freeMemory knows how much memory is given back
+    size_t * block = (size_t*)malloc(CSV_PARSER_POOL_HEADER_SIZE + size);
+    if (!block) {
+      out_of_memory = true;
+      return 0;
+    }
+    *block = size;
+    addMemoryUsed(size);
+    return (char*)block + CSV_PARSER_POOL_HEADER_SIZE;
+  }
+#endif
+  if (!pool) {
+    void * ptr = malloc(size);
+    if (!ptr && size)
+      out_of_memory = true;
+    return ptr;
+  }
+
+  size_t block_size = CSV_PARSER_POOL_HEADER_SIZE + alignPoolSize(size);
+  if (block_size > pool_size - pool_used) {
+    out_of_memory = true;
+    return 0;
+  }
+  char * block = pool + pool_used;
+  *(size_t*)block = size;
+  pool_used += block_size;
+  if (pool_used > pool_high_water_mark)
+    pool_high_water_mark = pool_used;
+  return block + CSV_PARSER_POOL_HEADER_SIZE;
+}
+
+void * CSV_Parser::reallocMemory(void * ptr, size_t size) {
+#ifdef CSV_PARSER_ENABLE_STATS
+  if (!ptr)
+    return allocMemory(size);
+  stats.reallocs++;
+  stats.allocated_bytes += size;
+  if (!pool) {
+    size_t * block = (size_t*)((char*)ptr - CSV_PARSER_POOL_HEADER_SIZE);
+    size_t old_size = *block;
+    block = (size_t*)realloc(block, CSV_PARSER_POOL_HEADER_SIZE + size);
+    if (!block) {
+      out_of_memory = true;
+      return 0;
+    }
+    *block = size;
+    stats.memory_used -= old_size;
+    addMemoryUsed(size);
+    return (char*)block + CSV_PARSER_POOL_HEADER_SIZE;
+  }
+#endif
+  if (!pool) {
+    void * new_ptr = realloc(ptr, size);
+    if (!new_ptr && size)
+      out_of_memory = true;
+    return new_ptr;
+  }
+
+  if (!ptr)
+    return allocMemory(size);
+
+  size_t * old_size = (size_t*)((char*)ptr - CSV_PARSER_POOL_HEADER_SIZE);
+  bool is_last_block = (char*)ptr + alignPoolSize(*old_size) == pool + pool_used;
+  if (is_last_block) {
+    size_t block_start = (char*)old_size - pool;
+    size_t block_size = CSV_PARSER_POOL_HEADER_SIZE + alignPoolSize(size);
+    if (block_size > pool_size - block_start) {
+      out_of_memory = true;
+      return 0;
+    }
+    *old_size = size;
+    pool_used = block_start + block_size;
+    if (pool_used > pool_high_water_mark)
+      pool_high_water_mark = pool_used;
+    return ptr;
+  }
+
+  void * new_ptr = allocMemory(size);
+  if (!new_ptr)
+    return 0;
+  memcpy(new_ptr, ptr, *old_size < size ? *old_size : size);
+  return new_ptr;
+}
+
+void CSV_Parser::freeMemory(void * ptr) {
+#ifdef CSV_PARSER_ENABLE_STATS
+  if (!ptr)
+    return;
+  stats.frees++;
+  if (!pool) {
+    size_t * block = (size_t*)((char*)ptr - CSV_PARSER_POOL_HEADER_SIZE);
+    stats.memory_used -= *block;
+    free(block);
+    return;
+  }
+#endif
+  if (!pool) {
+    free(ptr);
+    return;
+  }
+  if (!ptr)
+    return;
+
+  // only the last block can be given back to the pool
+  size_t * size = (size_t*)((char*)ptr - CSV_PARSER_POOL_HEADER_SIZE);
+  if ((char*)ptr + alignPoolSize(*size) == pool + pool_used)
+    pool_used = (char*)size - pool;
+}
+
+#ifdef CSV_PARSER_ENABLE_STATS
+void CSV_Parser::addMemoryUsed(size_t size) {
+  stats.memory_used += size;
+  if (stats.memory_used > stats.memory_peak)
+    stats.memory_peak = stats.memory_used;
+}
+
+CSV_Parser::StatsTime CSV_Parser::statsTime() {
+#ifdef NON_ARDUINO
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+  return micros();
+#endif
+}
+
+/*  Tokenizing time is what remains of the time spent in parseChunk/parseLastValue after the other phases are subtracted.  */
+CSV_Stats CSV_Parser::getStats() {
+  CSV_Stats result = stats;
+  if (pool) {
+    result.memory_used = pool_used;
+    result.memory_peak = pool_high_water_mark;
+  }
+  result.conversion_errors = conversion_errors;
+  StatsTime other_time = convert_time + store_time + callback_time;
+  StatsTime times[] = {parse_time > other_time ? parse_time - other_time : 0, convert_time, store_time, callback_time};
+  uint32_t * results[] = {&result.tokenize_us, &result.convert_us, &result.store_us, &result.callback_us};
+  for (int i = 0; i < 4; i++) {
+#ifdef NON_ARDUINO
+    *results[i] = times[i] / 1000;
+#else
+    *results[i] = times[i];
+#endif
+  }
+  return result;
+}
+#endif
+
+/*  Returns the largest block that can still be carved from the pool.  */
+size_t CSV_Parser::poolAvailable() {
+  size_t free_size = pool_size - pool_used;
+  return free_size > CSV_PARSER_POOL_HEADER_SIZE ? (free_size - CSV_PARSER_POOL_HEADER_SIZE) / CSV_PARSER_POOL_ALIGNMENT * CSV_PARSER_POOL_ALIGNMENT : 0;
+}
+
+bool CSV_Parser::outOfMemory() { return out_of_memory; }
+int CSV_Parser::getConversionErrorsCount() { return conversion_errors; }
+size_t CSV_Parser::highWaterMark() { return pool_high_water_mark; }
+
 /*  It populates "is_fmt_unsigned" array. To clarify:
         fmt_ = format supplied in constructor (including "u", if there are values to be stored as unsigned)
         fmt  = member, format without "u" if any was there  */
 void CSV_Parser::AssignIsFmtUnsignedArray(const char * fmt_) {
-  is_fmt_unsigned = (char*)malloc(strlen(fmt));
-
   int sz = strlen(fmt);
+  is_fmt_unsigned = (char*)allocMemory(sz);
+  if (!is_fmt_unsigned)
+    return;
+
   for (int i = 0; i < sz; i++) {
     if (fmt_[i] == 'u') {
       fmt_++;
@@ -83,13 +395,26 @@ void CSV_Parser::AssignIsFmtUnsignedArray(const char * fmt_) {
     } else {
       is_fmt_unsigned[i] = false;
     }
+    while (isdigit(fmt_[i + 1]))
+      fmt_++; // scale of "q" specifier
   }
 }
 
-CSV_Parser::CSV_Parser(const char * s, const char * fmt_, bool has_header_, char delimiter_, char quote_char_) :
-  fmt( strdup_ignoring_u(fmt_) ),
+CSV_Parser::CSV_Parser(void * pool_, size_t pool_size_, const char * s, const char * fmt_, bool has_header_, char delimiter_, char quote_char_) :
+  CSV_Parser(pool_, pool_size_, fmt_, (const ColumnStore*)0, has_header_, delimiter_, quote_char_)
+{
+  for (int col = 0; col < cols_count; col++)
+    column_store[col] = isAutoColumn(col) ? storeAutoInteger : getColumnStore(fmt[col], is_fmt_unsigned[col]);
+  if (s)
+    supplyChunk(s);
+}
+
+CSV_Parser::CSV_Parser(void * pool_, size_t pool_size_, const char * fmt_, const ColumnStore * stores, bool has_header_, char delimiter_, char quote_char_) :
+  fmt(0),
+  is_fmt_unsigned(0),
   rows_count(0), 
   cols_count( strlen_ignoring_u(fmt_) ),
+  rows_capacity(1),
   has_header(has_header_),
   delimiter(delimiter_),
   quote_char(quote_char_),
@@ -97,41 +422,179 @@ CSV_Parser::CSV_Parser(const char * s, const char * fmt_, bool has_header_, char
   whole_csv_supplied(false),
   //whole_csv_supplied((bool)s ? true : false), // in constructor where whole csv is not supplied at once it should be set to false
   leftover(0),
+  leftover_start(0),
+  leftover_len(0),
+  leftover_capacity(0),
   current_col(0),
   header_parsed(!has_header_),
+  ignore_next_delimchar(false),
+  last_used_col(-1),
+  skipping_row(false),
+  skip_in_quotes(false),
+  skip_in_value(false),
+  string_slabs(0),
+  scan_resume(0),
+  scan_ending_quote(0),
+  scan_escaped_quotes(0),
+#if defined(CSV_PARSER_SIMD)
+  scan_block(0),
+#endif
+  column_store(0),
+  fixed_scales(0),
+  auto_columns(0),
+  aggregates(0),
+  column_filters(0),
+  row_rejected(false),
+  rows_accepted(0),
+  rows_rejected(0),
+  row_slab(0),
+  row_slab_next(0),
+  row_slab_used(0),
+  struct_array(0),
+  struct_size(0),
+  struct_capacity(0),
+  struct_array_owned(false),
+  bound_columns(0),
   feedRowParser_callback(feedRowParser),
   feedRowParserStr_callback(feedRowParserStr),
-  rowParserFinished_callback(rowParserFinished)
+  rowParserFinished_callback(rowParserFinished),
+  fillBuffer_callback(0),
+  rows_limit(0),
+  row_callback(0),
+  row_callback_data(0),
+  rows_visited(0),
+  row_start(0),
+  row_resume(0),
+  string_offsets(0),
+  window_size(0),
+  window_next(0),
+  rows_parsed(0),
+  window_strings(0),
+  window_string_len(0),
+  row_offsets(0),
+  row_offsets_count(0),
+  row_offsets_capacity(0),
+  row_offsets_step(0),
+  indexed_rows(0),
+  rows_to_skip(0),
+  seek_callback(0),
+#ifdef NON_ARDUINO
+  mapping(0),
+  mapping_size(0),
+  string_views(false),
+#endif
+  pool(0),
+  pool_size(0),
+  pool_used(0),
+  pool_high_water_mark(0),
+  out_of_memory(false),
+  row_dropped(false),
+  conversion_errors(0),
+#ifdef CSV_PARSER_ENABLE_STATS
+  stats(),
+  parse_time(0),
+  convert_time(0),
+  store_time(0),
+  callback_time(0),
+#endif
+  key_index(0),
+  key_index_size(0)
 {  
-  AssignIsFmtUnsignedArray(fmt_);
+  if (pool_) {
+    // all blocks carved from the pool are aligned, so the beginning of the pool must be aligned too
+    size_t misalignment = (uintptr_t)pool_ % CSV_PARSER_POOL_ALIGNMENT;
+    size_t skipped = misalignment ? CSV_PARSER_POOL_ALIGNMENT - misalignment : 0;
+    if (pool_size_ > skipped) {
+      pool = (char*)pool_ + skipped;
+      pool_size = pool_size_ - skipped;
+    } else {
+      // pool too small to be used at all, every allocation will fail (instead of falling back to the heap)
+      pool = (char*)pool_;
+    }
+  }
+
+  fmt = strdup_ignoring_u(fmt_);
+  if (fmt)
+    AssignIsFmtUnsignedArray(fmt_);
   
-  keys =   (char**)calloc(cols_count, sizeof(char*));         // calloc fills memory with 0's so then I can simply use "if(keys[i]) { do something with key[i] }"
-  values = (void**)calloc(cols_count, sizeof(void*));
+  keys =   (char**)allocMemory(cols_count * sizeof(char*));
+  values = (void**)allocMemory(cols_count * sizeof(void*));
+  column_store = (ColumnStore*)allocMemory(cols_count * sizeof(ColumnStore));
+  bool has_auto_columns = fmt && strchr(fmt, 'a');
+  if (has_auto_columns)
+    auto_columns = (AutoColumn*)allocMemory(cols_count * sizeof(AutoColumn));
+  bool has_fixed_columns = fmt && strchr(fmt, 'q');
+  if (has_fixed_columns)
+    fixed_scales = (uint8_t*)allocMemory(cols_count);
+  if (!fmt || !is_fmt_unsigned || !keys || !values || !column_store || (has_auto_columns && !auto_columns) || (has_fixed_columns && !fixed_scales)) {
+    // nothing can be parsed without these, cols_count = 0 makes all methods safe to call
+    cols_count = 0;
+    return;
+  }
 
-  for (int col = 0; col < cols_count; col++)
-      values[col] = malloc(getTypeSize(fmt[col])); 
+  // keys and values are filled with 0's so then I can simply use "if(keys[i]) { do something with key[i] }"
+  memset(keys, 0, cols_count * sizeof(char*));
+  if (auto_columns)
+    memset(auto_columns, 0, cols_count * sizeof(AutoColumn));
+  if (fixed_scales) {
+    // digit following "q" is the number of decimal places (0 if it's missing)
+    int col = 0;
+    for (const char * p = fmt_; *p; p++) {
+      if (*p == 'u' || isdigit(*p))
+        continue;
+      fixed_scales[col++] = *p == 'q' && isdigit(p[1]) ? p[1] - '0' : 0;
+    }
+  }
+  for (int col = 0; col < cols_count; col++) {
+      if (fmt[col] == 'a') {
+        // auto integer column starts with the narrowest type ("u" before "a" doesn't matter)
+        auto_columns[col].used = true;
+        fmt[col] = 'c';
+        is_fmt_unsigned[col] = true;
+      }
+      values[col] = allocMemory(getTypeSize(fmt[col])); 
+      column_store[col] = stores ? stores[col] : 0; // without "stores" they're assigned by the calling constructor
+      if (fmt[col] != '-')
+        last_used_col = col;
+  }
 
   /*mem.check("constructor");
   mem.check("after calloc 1, should be = " + String(cols_count * sizeof(char*)));
   mem.check("after calloc 2, should be = " + String(cols_count * sizeof(void*)));*/ 
-  if (s)
-    supplyChunk(s);
 }
 
 CSV_Parser::~CSV_Parser() {
+  freeStrings(false);
   for (int col = 0; col < cols_count; col++) {
-    if (fmt[col] == 's')
-      for (int row = 0; row < rows_count; row++)
-        free(((char**)values[col])[row]);
-    
-    free(keys[col]);
-    free(values[col]);
+    freeMemory(keys[col]);
+    freeMemory(values[col]);
+    for (ColumnFilter * filter = column_filters ? column_filters[col] : 0; filter; ) {
+      ColumnFilter * next = filter->next;
+      freeMemory(filter);
+      filter = next;
+    }
   }
-  free(keys);
-  free(values);
-  free(fmt);
-  free(leftover);
-  free(is_fmt_unsigned);
+  freeMemory(keys);
+  freeMemory(values);
+  freeMemory(column_store);
+  freeMemory(fixed_scales);
+  freeMemory(auto_columns);
+  freeMemory(aggregates);
+  freeMemory(column_filters);
+  freeMemory(bound_columns);
+  if (struct_array_owned)
+    freeMemory(struct_array);
+  freeMemory(key_index);
+  freeMemory(string_offsets);
+  freeMemory(window_strings);
+  freeMemory(row_offsets);
+  freeMemory(fmt);
+  freeMemory(leftover);
+  freeMemory(is_fmt_unsigned);
+#ifdef NON_ARDUINO
+  if (mapping)
+    munmap(mapping, mapping_size);
+#endif
 }
 
 bool CSV_Parser::parseRow() {
@@ -145,19 +608,37 @@ bool CSV_Parser::parseRow() {
   //        char *str = strings[0];
   //     }
 
-  if (rowParserFinished_callback()) 
+  // "leftover" may hold the following rows of the previously supplied block (parsing stops after each row)
+  bool pending = leftover_start != leftover_len;
+  if (!fillBuffer_callback && !pending && rowParserFinished_callback()) 
     return false;
 
-  // It is necessary to deallocate memory for previously saved strings 
-  // (because strdup is used for saving strings which allocates new memory)
+  // Previously saved strings are not needed anymore, the arena slab is kept to be reused by the next row 
+  // (the use of parseRow implies that only 1 row is parsed at a time)
   if (rows_count > 0) {
-    for (int col = 0; col < cols_count; col++) {
-      if (fmt[col] == 's')
-        free(((char**)values[col])[0]); // 0 stands for the first row, the use of parseRow implies that only 1 row is parsed at a time
-    }
+    freeStrings(true);
     rows_count = 0;
   }
 
+  rows_limit = 1;
+  if (pending)
+    parseAppendedLeftover(0);
+
+  if (fillBuffer_callback) {
+    while (rows_count == 0) {
+      if (!reserveLeftover(CSV_PARSER_READ_BLOCK_SIZE))
+        break;
+      size_t n = fillBuffer_callback(leftover + leftover_len, CSV_PARSER_READ_BLOCK_SIZE);
+      if (!n) {
+        parseLeftover();
+        break;
+      }
+      parseAppendedLeftover(n);
+    }
+    rows_limit = 0;
+    return rows_count > 0;
+  }
+
   while (!rowParserFinished_callback() && rows_count == 0) {
     char c = feedRowParser_callback();
     if (c) {
@@ -170,8 +651,9 @@ bool CSV_Parser::parseRow() {
   }
   // thanks to the line below the csv could end without '\n' and the last value 
   // would still be parsed if the rowParserFinished() returns true
-  if (rowParserFinished_callback())
+  if (rows_count == 0 && rowParserFinished_callback())
     parseLeftover();
+  rows_limit = 0;
   return rows_count > 0;
 }
 
@@ -184,9 +666,15 @@ bool CSV_Parser::readSDfile(const char *f_name) {
   if (!csv_file) 
     return false;
     
-  // read file and supply it to csv parser
-  while (csv_file.available())
-    *this << (char)csv_file.read();
+  // read file by blocks directly into leftover buffer and parse them in place
+  while (csv_file.available()) {
+    if (!reserveLeftover(CSV_PARSER_READ_BLOCK_SIZE))
+      break;
+    int n = csv_file.read((uint8_t*)leftover + leftover_len, CSV_PARSER_READ_BLOCK_SIZE);
+    if (n <= 0)
+      break;
+    parseAppendedLeftover(n);
+  }
   
   csv_file.close();
   
@@ -196,198 +684,1203 @@ bool CSV_Parser::readSDfile(const char *f_name) {
 }
 #endif
 
-/*  It ensures that '\r\n' characters, delimiter and quote characters that are enclosed within string 
-    value itself are properly parsed. It dynamically allocates memory, creates copy of parsed string 
-    value and returns a pointer to it. Memory is supposed to be released outside of this function.  
-*/
-char * CSV_Parser::parseStringValue(const char * s, int * chars_occupied) {
-  if (!s) {
-	  *chars_occupied = 0;
-	  return 0;
-  }
-  
-  /*  If value is not enclosed in double quotes  */
-  if(*s != quote_char) {
-    char * first_delim = strpbrk(s, delim_chars);
-    int val_len = 0;
-    if (!first_delim && !whole_csv_supplied) {
-      // delim_chars not found in string
-      *chars_occupied = 0;
-      return 0;
-    }
+#ifdef NON_ARDUINO
+bool CSV_Parser::readFile(const char *f_name) {
+  int fd = open(f_name, O_RDONLY);
+  if (fd < 0)
+    return false;
+  bool success = readFd(fd);
+  close(fd);
+  return success;
+}
 
-    if (first_delim) {
-      val_len = first_delim - s;
-      *chars_occupied = val_len + (*first_delim == delimiter) + strspn(first_delim, "\r\n");
+bool CSV_Parser::readFd(int fd) {
+  bool success = true;
+  while (true) {
+    if (!reserveLeftover(CSV_PARSER_READ_BLOCK_SIZE)) {
+      success = false;
+      break;
     }
-    else {
-      val_len = strlen(s);
-      *chars_occupied = val_len;
+    ssize_t n = read(fd, leftover + leftover_len, CSV_PARSER_READ_BLOCK_SIZE);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      success = n == 0;
+      break;
     }
-      
-    //return strndup(s, *chars_occupied); // available for Esp8266 but not for Arduino :(
-    char *str = (char*)malloc(val_len + 1);
-    memcpy(str, s, val_len);
-    str[val_len] = 0;
-    return str;
+    parseAppendedLeftover(n);
   }
+  
+  // ensure that the last value of the file is parsed (even if the file doesn't end with '\n')
+  parseLeftover();
+  return success;
+}
+#endif
 
-  /*  If value is enclosed in double quotes. Being enclosed in double quotes automatically 
-      means that the total number of occupied characters is 2 more than usual.  */
-  *chars_occupied = 2;
-  s++;
-  const char * base = s;
-
-  int len = 0; 
-  bool ending_quote_found = false;
-  while (char *next_quote = strchr(s, quote_char)) {
-    if (*(next_quote+1) == quote_char) {
-  	  s = next_quote+2;
-  	  len--;
-  	  continue;
-  	}
-    // only assume the current quote is the ending quote if the next character is a delimiter or a new line
-    // WARNING: parseLeftover does not need such condition, "whole_csv_supplied" can be used to check if parseLeftover was used
-    if (!whole_csv_supplied && !strpbrk(next_quote + 1, delim_chars)) {
-      s = next_quote + 1;
+/*  Snapshot layout (values are in the byte order of the machine that saved them):
+      SnapshotHeader
+      keys of used columns (if has_keys): uint16_t length + chars
+      values of used columns: raw array of rows_count values, or for "s" columns: 
+        uint32_t length + all strings of the column (each terminated by 0)
+        (array of "a" column is preceded by its current type: specifier char + is_unsigned byte)  */
+#define CSV_PARSER_SNAPSHOT_VERSION 1
+
+struct SnapshotHeader {
+  char magic[4];        // "CSVS"
+  uint8_t version;
+  uint8_t has_keys;
+  uint16_t cols_count;
+  uint32_t format_hash; // FNV-1a of format specifiers (including "u"), loading fails if the format is different
+  uint32_t rows_count;
+};
+
+uint32_t CSV_Parser::formatHash() {
+  uint32_t hash = 2166136261UL;
+  for (int col = 0; col < cols_count; col++) {
+    if (isAutoColumn(col)) {
+      hash = (hash ^ 'a') * 16777619UL;
       continue;
     }
-    ending_quote_found = true;
-  	
-  	*chars_occupied += next_quote - base;
-  	len += next_quote - base;
-  	
-  	if ((*(next_quote+1) == delimiter))
-  		*chars_occupied += 1;
-  	else
-  		*chars_occupied += strspn(next_quote + 1, "\r\n");
-  	
-  	break;
+    if (is_fmt_unsigned[col])
+      hash = (hash ^ 'u') * 16777619UL;
+    hash = (hash ^ (uint8_t)fmt[col]) * 16777619UL;
+    if (fmt[col] == 'q')
+      hash = (hash ^ ('0' + fixed_scales[col])) * 16777619UL;
   }
+  return hash;
+}
 
-  if (!ending_quote_found) {
-    *chars_occupied = 0;
-    return 0;
-  }
+bool CSV_Parser::writeSnapshot(SnapshotWrite write, void * ctx) {
+  if (row_callback || window_size || aggregates || struct_array)
+    return false;
+  SnapshotHeader header;
+  memcpy(header.magic, "CSVS", 4);
+  header.version = CSV_PARSER_SNAPSHOT_VERSION;
+  header.has_keys = has_header;
+  header.cols_count = cols_count;
+  header.format_hash = formatHash();
+  header.rows_count = rows_count;
+  if (!write(ctx, &header, sizeof(header)))
+    return false;
 
-  /*  Copy string and turn 2's of adjacent double quotes into 1's.  */
-  char * new_s = (char*)malloc(len + 1);
-  new_s[len] = 0;
-  char * base_new_s = new_s;
-  
-  s = base;
-  for (int i = 0; i < len; i++) {
-    *new_s++ = *s++;
-    if (*(s-1) == quote_char && *s == quote_char)
-      s += 1;
+  for (int col = 0; col < cols_count && has_header; col++) {
+    if (fmt[col] == '-')
+      continue;
+    uint16_t len = keys[col] ? strlen(keys[col]) : 0;
+    if (!write(ctx, &len, sizeof(len)) || !write(ctx, keys[col], len))
+      return false;
   }
-  return base_new_s;
-}
 
-
-int8_t CSV_Parser::getTypeSize(char type_specifier) {
-  switch (type_specifier) {
-    case 's': return sizeof(char*);   // c-like string
-    case 'f': return sizeof(float); 
-    case 'L': return sizeof(int32_t); // 32-bit signed number (not higher than 2147483647)       
-    case 'd': return sizeof(int16_t); // 16-bit signed number (not higher than 32767)
-    case 'c': return sizeof(char);    // 8-bit signed number  (not higher than 127)
-    case 'x': return sizeof(int32_t); // hex input is stored as long (32-bit signed number)
-    case '-': return 0;   
-    case   0: return 0;
-    default : return 0; //debug_serial->println("CSV_Parser, wrong fmt specifier = " + String(type_specifier));
+  for (int col = 0; col < cols_count; col++) {
+    int8_t type_size = valueSize(col);
+    if (!type_size)
+      continue;
+    char auto_type[2] = {fmt[col], is_fmt_unsigned[col]};
+    if (isAutoColumn(col) && !write(ctx, auto_type, sizeof(auto_type)))
+      return false;
+    if (fmt[col] != 's') {
+      if (!write(ctx, values[col], (size_t)rows_count * type_size))
+        return false;
+      continue;
+    }
+    // strings are written one after another, their total length goes first so they can be read at once
+    uint32_t len = 0;
+    for (int row = 0; row < rows_count; row++) {
+      CSV_String str = getStoredString(col, row);
+      len += str.len + 1;
+    }
+    if (!write(ctx, &len, sizeof(len)))
+      return false;
+    for (int row = 0; row < rows_count; row++) {
+      CSV_String str = getStoredString(col, row);
+      if (!write(ctx, str.s, str.len) || !write(ctx, "", 1))
+        return false;
+    }
   }
-  return 0;
+  return true;
 }
 
-const char * CSV_Parser::getTypeName(char type_specifier, bool is_unsigned) {
-  if (is_unsigned) {
-    switch(type_specifier){
-        case 'L': return "uint32_t";
-        case 'd': return "uint16_t";
-        case 'c': return "uint8_t";
-        case 'x': return "hex (uint32_t)"; // hex input, but it's stored as int32_t
+bool CSV_Parser::readSnapshot(SnapshotRead read, void * ctx) {
+  if (rows_count || current_col || leftover_len || row_callback || window_size || aggregates || struct_array || (has_header && header_parsed))
+    return false;
+  SnapshotHeader header;
+  if (!read(ctx, &header, sizeof(header)) || memcmp(header.magic, "CSVS", 4) || header.version != CSV_PARSER_SNAPSHOT_VERSION ||
+      header.has_keys != has_header || header.cols_count != cols_count || header.format_hash != formatHash() || 
+      header.rows_count > (uint32_t)INT_MAX)
+    return false; // rows are counted by int (the count of a damaged snapshot could become negative)
+  // auto columns are widened to the types stored in the snapshot while it's read, so their state is restored if it fails
+  char * saved_auto_columns = 0;
+  if (auto_columns) {
+    saved_auto_columns = (char*)allocMemory(cols_count * (2 + sizeof(AutoColumn)));
+    if (!saved_auto_columns) {
+      out_of_memory = true;
+      return false;
     }
+    memcpy(saved_auto_columns, fmt, cols_count);
+    memcpy(saved_auto_columns + cols_count, is_fmt_unsigned, cols_count);
+    memcpy(saved_auto_columns + 2 * cols_count, auto_columns, cols_count * sizeof(AutoColumn));
   }
-  
-  switch(type_specifier){
-      case 's': return "char*";          
-      case 'f': return "float";
-      case 'L': return "int32_t";
-      case 'd': return "int16_t";
-      case 'c': return "char";
-      case 'x': return "hex (int32_t)"; // hex input, but it's stored as int32_t
-      case '-': return "-";
-      case   0: return "-";
-      default : return "unknown";
+  bool was_out_of_memory = out_of_memory;
+  bool loaded = readSnapshotData(read, ctx, header.rows_count);
+  if (saved_auto_columns && !loaded) {
+    memcpy(fmt, saved_auto_columns, cols_count);
+    memcpy(is_fmt_unsigned, saved_auto_columns + cols_count, cols_count);
+    memcpy(auto_columns, saved_auto_columns + 2 * cols_count, cols_count * sizeof(AutoColumn));
+  }
+  freeMemory(saved_auto_columns);
+  if (loaded)
+    return true;
+
+  // the parser is left as it was before, so the csv can be parsed instead (values arrays may keep the reserved capacity)
+  out_of_memory = was_out_of_memory;
+  for (int col = 0; col < cols_count; col++) {
+    freeMemory(keys[col]);
+    keys[col] = 0;
   }
+  freeMemory(key_index);
+  key_index = 0;
+  key_index_size = 0;
+  freeStrings(false);
+  header_parsed = !has_header;
+  return false;
 }
 
-void CSV_Parser::saveNewValue(const char * val, char type_specifier, int row, int col, bool is_unsigned) {
-  if (is_unsigned) {
-    switch (type_specifier) {
-      /*  If at this point type_specifier is 's' or 'f', then format was probably invalid. 
-          Only 'L', 'd', 'c', 'x' values could be preceded with 'u' (and be stored as unsigned types).  */
-      case 'L': { ((uint32_t*)values[col])[row] = (uint32_t)strtoul(val, 0, 10); break; } // 32-bit unsigned number (not higher than 4294967295, not lower than 0) 
-      case 'd': { ((uint16_t*)values[col])[row] = (uint16_t)strtoul(val, 0, 10); break; } // 16-bit unsigned number (not higher than 65535, not lower than 0)
-      case 'c': { ((uint8_t*) values[col])[row] = (uint8_t)strtoul(val, 0, 10); break; } // 8-bit  unsigned number (not higher than 255, not lower than 0)
-      case 'x': { ((uint32_t*)values[col])[row] = (uint32_t)strtoul(val, 0, 16); break; } // 32-bit unsigned number (not higher than 4294967295, not lower than 0)
-      case '-': break;
+bool CSV_Parser::readSnapshotData(SnapshotRead read, void * ctx, int rows) {
+  for (int col = 0; col < cols_count && has_header; col++) {
+    if (fmt[col] == '-')
+      continue;
+    uint16_t len;
+    if (!read(ctx, &len, sizeof(len)))
+      return false;
+    char * key = (char*)allocMemory(len + 1);
+    if (!key) {
+      out_of_memory = true;
+      return false;
     }
-    return;
+    keys[col] = key;
+    if (!read(ctx, key, len))
+      return false;
+    key[len] = 0;
   }
-  
-  switch (type_specifier) {
-    case 's': { ((char**)  values[col])[row] = strdup(val);                 break; } // c-like string
-    case 'f': { ((float*)  values[col])[row] = (float)atof(val);            break; }
-    case 'L': { ((int32_t*)values[col])[row] = (int32_t)atol(val);          break; } // 32-bit signed number (not higher than 2147483647) 
-    case 'd': { ((int16_t*)values[col])[row] = (int16_t)atoi(val);          break; } // 16-bit signed number (not higher than 32767)
-    case 'c': { ((char*)   values[col])[row] = (char)atoi(val);             break; } // 8-bit signed number  (not higher than 127)
-    case 'x': { ((int32_t*)values[col])[row] = (int32_t)strtol(val, 0, 16); break; } // hex input is stored as long (32-bit signed number)
-    case '-': break;
+  header_parsed = true;
+  buildKeyIndex();
+
+  if (rows < 0)
+    return false;
+  if (!reserve(rows) || rows > rows_capacity) {
+    out_of_memory = true;
+    return false;
+  }
+  for (int col = 0; col < cols_count; col++) {
+    if (isAutoColumn(col)) {
+      char auto_type[2];
+      if (!read(ctx, auto_type, sizeof(auto_type)) || !auto_type[0] || !strchr("cdL", auto_type[0]) || 
+          !widenColumn(col, auto_type[0], auto_type[1]))
+        return false;
+      // values appended later are compared with the limits of the type (values of the snapshot aren't checked)
+      uint8_t bits = getTypeSize(auto_type[0]) * 8;
+      auto_columns[col].max_positive = (uint32_t)0xFFFFFFFF >> (32 - bits + !auto_type[1]);
+      auto_columns[col].max_negative = auto_type[1] ? 0 : (uint32_t)1 << (bits - 1);
+    }
+    int8_t type_size = getTypeSize(fmt[col]);
+    if (!type_size)
+      continue;
+    if (fmt[col] != 's') {
+      if (!read(ctx, values[col], (size_t)rows * type_size))
+        return false;
+      continue;
+    }
+    uint32_t len;
+    if (!read(ctx, &len, sizeof(len)))
+      return false;
+    if (!len)
+      continue;
+    char * strings = allocString(len - 1);
+    if (!strings) {
+      out_of_memory = true;
+      return false;
+    }
+    if (!read(ctx, strings, len) || strings[len - 1])
+      return false;
+    // pointers are restored by finding the terminating 0's
+    const char * s = strings;
+    const char * end = strings + len;
+    for (int row = 0; row < rows; row++) {
+      if (s == end)
+        return false;
+      ((char**)values[col])[row] = (char*)s;
+      s += strlen(s) + 1;
+    }
   }
+  rows_count = rows;
+  return true;
 }
 
-void CSV_Parser::printKeys(Stream &ser) {
-  #ifndef NON_ARDUINO
-  ser.println("Keys:");
-  for (int col = 0; col < cols_count; col++) 
-    ser.println(String(col) + ". Key = " + String(keys[col] ? keys[col] : "unused"));
-  #else 
-    printf("Keys:\n");
-  for (int col = 0; col < cols_count; col++)
-    printf("%d. Key = %s\n", col, keys[col] ? keys[col] : "unused");
-  #endif
+static bool writeToStream(void * stream, const void * data, size_t len) {
+  return ((Stream*)stream)->write((const uint8_t*)data, len) == len;
 }
 
-int CSV_Parser::getColumnsCount() { return cols_count; }
-int CSV_Parser::getRowsCount() { return rows_count; } // excluding header
+static bool readFromStream(void * stream, void * data, size_t len) {
+  return ((Stream*)stream)->readBytes((char*)data, len) == len;
+}
 
-/*  Get values pointer given column name (key in other words)  */
-void * CSV_Parser::operator [] (const char *key) { 
-    for (int col = 0; col < cols_count; col++) 
-    if (keys[col] && !strcmp(keys[col], key))
-      return values[col];
-  return (void*)0;
+bool CSV_Parser::saveSnapshot(Stream & out) { return writeSnapshot(writeToStream, &out); }
+bool CSV_Parser::loadSnapshot(Stream & in) { return readSnapshot(readFromStream, &in); }
+
+#ifdef NON_ARDUINO
+static bool writeToFile(void * file, const void * data, size_t len) {
+  return fwrite(data, 1, len, (FILE*)file) == len;
 }
 
-/*  Get values pointer given column index (0 being the first column)  */
-void * CSV_Parser::operator [] (int index) { return index < cols_count ? values[index] : (void*)0; }
+/*  Mapped snapshot is read by copying from the mapping (values arrays can't point into it, they must stay resizable).  */
+struct MappedInput {
+  const char * s;
+  const char * end;
+};
 
-/*  Prints column names, their types and all stored values.  */
-void CSV_Parser::print(Stream &ser) {
-  ser.println("CSV_Parser content:");
-  ser.print("rows_count = ");
-  ser.print(rows_count, DEC);
-  ser.print(", cols_count = ");
-  ser.println(cols_count, DEC);
-  if (has_header) {
-    ser.println("   Header:");
-    ser.print("      ");
-    for (int col = 0; col < cols_count; col++) { 
-      ser.print(keys[col] ? keys[col] : " - "); if(col == cols_count - 1) { continue; }
-      ser.print(" | ");
-    }
+static bool readFromMapping(void * input, void * data, size_t len) {
+  MappedInput * in = (MappedInput*)input;
+  if ((size_t)(in->end - in->s) < len)
+    return false;
+  memcpy(data, in->s, len);
+  in->s += len;
+  return true;
+}
+
+bool CSV_Parser::saveSnapshot(const char * f_name) {
+  FILE * file = fopen(f_name, "wb");
+  if (!file)
+    return false;
+  bool success = writeSnapshot(writeToFile, file);
+  return fclose(file) == 0 && success;
+}
+
+bool CSV_Parser::loadSnapshot(const char * f_name) {
+  int fd = open(f_name, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  void * area = fstat(fd, &st) == 0 && st.st_size > 0 ? mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (area == MAP_FAILED)
+    return false;
+  madvise(area, st.st_size, MADV_SEQUENTIAL);
+  MappedInput in = { (const char*)area, (const char*)area + st.st_size };
+  bool success = readSnapshot(readFromMapping, &in);
+  munmap(area, st.st_size);
+  return success;
+}
+#endif
+
+/*  Returns pointer to the first delimiter, '\r' or '\n' char between s and end (or end if there's none).  */
+inline const char * CSV_Parser::findDelimChar(const char * s, const char * end) {
+#if defined(CSV_PARSER_SIMD)
+  return findStructuralChar(s, end, false);
+#else
+  // parsed chunks are always terminated by 0 at "end" (or somewhere after it in case of parseParallel)
+  const char * found = strpbrk(s, delim_chars);
+  return found && found < end ? found : end;
+#endif
+}
+
+/*  Returns pointer to the first quote char between s and end (or end if there's none).  */
+inline const char * CSV_Parser::findQuoteChar(const char * s, const char * end) {
+#if defined(CSV_PARSER_SIMD)
+  return findStructuralChar(s, end, true);
+#else
+  const char * found = (const char*)memchr(s, quote_char, end - s);
+  return found ? found : end;
+#endif
+}
+
+#if defined(CSV_PARSER_SIMD)
+/*  Masks of the most recently scanned 64-byte block are kept, so consecutive values within the same block 
+    are found without scanning it again. scan_block must be reset whenever the parsed data changes.  */
+inline const char * CSV_Parser::findStructuralChar(const char * s, const char * end, bool quote) {
+  while (s < end) {
+    if (s < scan_block || s >= scan_block + 64) {
+      if (end - s < 64) {
+        // not enough data left for a whole block
+        for (; s < end; s++) 
+          if (quote ? *s == quote_char : (*s == delimiter || *s == '\r' || *s == '\n'))
+            return s;
+        return end;
+      }
+      scan_block = s;
+      scanBlock(s, delimiter, quote_char, &scan_delim_mask, &scan_quote_mask);
+    }
+    uint64_t mask = (quote ? scan_quote_mask : scan_delim_mask) >> (s - scan_block);
+    if (mask)
+      return s + __builtin_ctzll(mask);
+    s = scan_block + 64;
+  }
+  return end;
+}
+#endif
+
+/*  Returns the number of consecutive '\r' and '\n' chars starting at s.  */
+static int spanNewLines(const char * s, const char * end) {
+  const char * p = s;
+  while (p < end && (*p == '\r' || *p == '\n'))
+    p++;
+  return p - s;
+}
+
+/*  Numeric conversion functions below parse values directly from the parsed chunk (values are not terminated by 0). 
+    Leading and trailing spaces are allowed, empty value is converted to 0 (it's not considered invalid). 
+    They return false if the value was invalid (digits before the first invalid char are still converted) or 
+    out of range (the value is saturated then).  */
+
+static const char * skipSpaces(const char * s, const char * end) {
+  while (s < end && (*s == ' ' || *s == '\t'))
+    s++;
+  return s;
+}
+
+static inline int8_t digitValue(char c, uint8_t base) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (base == 16) {
+    c |= 0x20; // lower case
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  }
+  return -1;
+}
+
+/*  Parses decimal or hexadecimal (with optional "0x" prefix) integer. Magnitude of the result is limited to 
+    "max_positive" or "max_negative" (depending on the sign).  */
+static bool parseInteger(const char * s, const char * end, uint8_t base, uint32_t max_positive, uint32_t max_negative, bool * negative, uint32_t * magnitude) {
+  *negative = false;
+  *magnitude = 0;
+  s = skipSpaces(s, end);
+  if (s == end)
+    return true;
+
+  if (*s == '-' || *s == '+')
+    *negative = *s++ == '-';
+  if (base == 16 && end - s > 2 && s[0] == '0' && (s[1] | 0x20) == 'x')
+    s += 2;
+
+  uint32_t limit = *negative ? max_negative : max_positive;
+  uint32_t limit_div = limit / base;
+  uint8_t limit_mod = limit % base;
+  uint32_t mag = 0;
+  const char * digits_start = s;
+  int8_t digit;
+  for (; s < end && (digit = digitValue(*s, base)) >= 0; s++) {
+    if (mag > limit_div || (mag == limit_div && digit > limit_mod)) {
+      // saturate and skip remaining digits
+      *magnitude = limit;
+      return false;
+    }
+    mag = mag * base + digit;
+  }
+  *magnitude = mag;
+  return s != digits_start && skipSpaces(s, end) == end;
+}
+
+/*  Parses decimal number into integer holding "scale" decimal places (e.g. "-12.3" with scale 2 gives -1230) using integer 
+    arithmetic only. Further decimal places are rounded (half away from zero). Magnitude of the result is limited the same 
+    way as by parseInteger.  */
+static bool parseFixed(const char * s, const char * end, uint8_t scale, uint32_t max_positive, uint32_t max_negative, bool * negative, uint32_t * magnitude) {
+  *negative = false;
+  *magnitude = 0;
+  s = skipSpaces(s, end);
+  if (s == end)
+    return true;
+
+  if (*s == '-' || *s == '+')
+    *negative = *s++ == '-';
+
+  uint32_t limit = *negative ? max_negative : max_positive;
+  uint32_t mag = 0;
+  int fraction_digits = -1; // -1 until the decimal point is found
+  bool has_digits = false, round_up = false;
+  for (; s < end; s++) {
+    if (*s == '.' && fraction_digits < 0) {
+      fraction_digits = 0;
+      continue;
+    }
+    if (*s < '0' || *s > '9')
+      break;
+    has_digits = true;
+    if (fraction_digits >= scale) {
+      // only the first digit beyond the scale matters
+      if (fraction_digits++ == scale)
+        round_up = *s >= '5';
+      continue;
+    }
+    uint8_t digit = *s - '0';
+    if (mag > limit / 10 || (mag == limit / 10 && digit > limit % 10)) {
+      *magnitude = limit;
+      return false;
+    }
+    mag = mag * 10 + digit;
+    if (fraction_digits >= 0)
+      fraction_digits++;
+  }
+  // missing decimal places are 0's
+  for (int i = fraction_digits < 0 ? 0 : fraction_digits; i < scale; i++) {
+    if (mag > limit / 10) {
+      *magnitude = limit;
+      return false;
+    }
+    mag *= 10;
+  }
+  if (round_up) {
+    if (mag == limit) {
+      *magnitude = limit;
+      return false;
+    }
+    mag++;
+  }
+  *magnitude = mag;
+  return has_digits && skipSpaces(s, end) == end;
+}
+
+/*  Exactly representable powers of 10 used by parseFloat.  */
+static const double powers_of_10[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/*  Parses float with optional exponent. Values with more than 19 significant digits, big exponents or 
+    special forms (e.g. "inf") are passed to strtod instead (it requires copying the value).  */
+static bool parseFloat(const char * s, const char * end, float * result) {
+  *result = 0;
+  const char * p = skipSpaces(s, end);
+  if (p == end)
+    return true;
+
+  bool negative = false;
+  if (*p == '-' || *p == '+')
+    negative = *p++ == '-';
+
+  uint64_t mantissa = 0;
+  int significant_digits = 0, exponent = 0;
+  bool any_digits = false, dot_found = false;
+  for (; p < end; p++) {
+    if (*p == '.' && !dot_found) {
+      dot_found = true;
+      continue;
+    }
+    if (*p < '0' || *p > '9')
+      break;
+    any_digits = true;
+    if (mantissa || *p != '0')
+      significant_digits++;
+    mantissa = mantissa * 10 + (*p - '0'); // overflow (over 19 digits) is handled by the strtod fallback
+    if (dot_found)
+      exponent--;
+  }
+
+  if (any_digits && p < end && (*p == 'e' || *p == 'E')) {
+    const char * exp_start = p++;
+    bool exp_negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+      exp_negative = *p++ == '-';
+    int exp = 0;
+    const char * exp_digits = p;
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+      if (exp < 10000) 
+        exp = exp * 10 + (*p - '0');
+    if (p == exp_digits)
+      p = exp_start; // "e" not followed by digits isn't part of the number
+    else
+      exponent += exp_negative ? -exp : exp;
+  }
+
+  bool valid = any_digits && skipSpaces(p, end) == end;
+  if (valid && significant_digits <= 19 && mantissa <= ((uint64_t)1 << 53) && exponent >= -22 && exponent <= 22) {
+    // both mantissa and power of 10 are exact, so the result is correctly rounded (result can't exceed FLT_MAX here)
+    double val = exponent < 0 ? (double)mantissa / powers_of_10[-exponent] : (double)mantissa * powers_of_10[exponent];
+    *result = (float)(negative ? -val : val);
+    return true;
+  }
+  if (any_digits && !valid) {
+    // convert the digits that were found (like atof does)
+    end = p;
+  }
+
+  char buf[64];
+  size_t len = end - s;
+  if (len >= sizeof(buf))
+    return false;
+  memcpy(buf, s, len);
+  buf[len] = 0;
+  char * buf_end;
+  double val = strtod(buf, &buf_end);
+  if (fabs(val) > FLT_MAX && (any_digits || !isinf(val))) {
+    *result = val < 0 ? -FLT_MAX : FLT_MAX;
+    return false;
+  }
+  *result = (float)val;
+  return valid || (!any_digits && buf_end != buf && skipSpaces(buf_end, buf + len) == buf + len);
+}
+
+/*  It ensures that '\r\n' characters, delimiter and quote characters that are enclosed within string 
+    value itself are properly parsed. It doesn't copy the value, it only finds where it starts and how long it is
+    (after turning 2's of adjacent quote chars into 1's), copyValue can be used to copy it.
+    Returns false if the value isn't complete yet (its end wasn't found before "end").
+
+    When the value is incomplete, the progress is kept in scan_* members (as offsets from "s"), the next call
+    (with the same value at "s" and more data appended) continues from where this one stopped. Thanks to that
+    long values supplied in small chunks are scanned only once. 
+*/
+bool CSV_Parser::parseStringValue(const char * s, const char * end, int * chars_occupied, ParsedValue * val) {
+  if (!s) {
+	  *chars_occupied = 0;
+	  return false;
+  }
+  
+  /*  If value is not enclosed in double quotes  */
+  if(s == end || *s != quote_char) {
+    const char * first_delim = findDelimChar(s + scan_resume, end);
+    int val_len = first_delim - s;
+    if (first_delim == end && !whole_csv_supplied) {
+      // delim_chars not found in string
+      scan_resume = val_len;
+      *chars_occupied = 0;
+      return false;
+    }
+
+    if (first_delim != end)
+      *chars_occupied = val_len + (*first_delim == delimiter) + spanNewLines(first_delim, end);
+    else
+      *chars_occupied = val_len;
+      
+    val->s = s;
+    val->len = val_len;
+    val->quoted = false;
+    scan_resume = 0;
+    return true;
+  }
+
+  /*  If value is enclosed in double quotes. Being enclosed in double quotes automatically 
+      means that the total number of occupied characters is 2 more than usual.  */
+  const char * base = s + 1;
+  const char * p = scan_resume ? s + scan_resume : base;
+  const char * ending_quote = scan_ending_quote ? s + scan_ending_quote : 0;
+
+  while (!ending_quote) {
+    const char * next_quote = findQuoteChar(p, end);
+    if (next_quote == end || (next_quote + 1 == end && !whole_csv_supplied)) {
+      // it can't be determined yet whether a quote at the end is the ending one or the first of 2 adjacent quotes
+      scan_resume = next_quote - s;
+      *chars_occupied = 0;
+      return false;
+    }
+    if (next_quote + 1 < end && *(next_quote+1) == quote_char) {
+      p = next_quote + 2;
+      scan_escaped_quotes++;
+      continue;
+    }
+    ending_quote = next_quote;
+    p = next_quote + 1;
+  }
+
+  // only assume the current quote is the ending quote if it's followed by a delimiter or a new line
+  // WARNING: parseLeftover does not need such condition, "whole_csv_supplied" can be used to check if parseLeftover was used
+  if (!whole_csv_supplied && findDelimChar(p, end) == end) {
+    scan_ending_quote = ending_quote - s;
+    scan_resume = end - s;
+    *chars_occupied = 0;
+    return false;
+  }
+
+  *chars_occupied = 2 + (ending_quote - base);
+  if (ending_quote + 1 < end && *(ending_quote+1) == delimiter)
+    *chars_occupied += 1;
+  else
+    *chars_occupied += spanNewLines(ending_quote + 1, end);
+
+  val->s = base;
+  val->len = (ending_quote - base) - scan_escaped_quotes;
+  val->quoted = true;
+  scan_resume = scan_ending_quote = scan_escaped_quotes = 0;
+  return true;
+}
+
+
+int8_t CSV_Parser::getTypeSize(char type_specifier) {
+  switch (type_specifier) {
+    case 's': return sizeof(char*);   // c-like string
+    case 'f': return sizeof(float); 
+    case 'L': return sizeof(int32_t); // 32-bit signed number (not higher than 2147483647)       
+    case 'd': return sizeof(int16_t); // 16-bit signed number (not higher than 32767)
+    case 'c': return sizeof(char);    // 8-bit signed number  (not higher than 127)
+    case 'x': return sizeof(int32_t); // hex input is stored as long (32-bit signed number)
+    case 'q': return sizeof(int32_t); // fixed-point number stored as 32-bit integer (multiplied by 10^scale)
+    case '-': return 0;   
+    case   0: return 0;
+    default : return 0; //debug_serial->println("CSV_Parser, wrong fmt specifier = " + String(type_specifier));
+  }
+  return 0;
+}
+
+int8_t CSV_Parser::valueSize(int col) const {
+  if (isAggregated(col) || isBound(col))
+    return 0; // only the last value is kept
+#ifdef NON_ARDUINO
+  if (fmt[col] == 's' && string_views)
+    return sizeof(CSV_String);
+#endif
+  return getTypeSize(fmt[col]);
+}
+
+CSV_String CSV_Parser::getStoredString(int col, int row) const {
+#ifdef NON_ARDUINO
+  if (string_views)
+    return ((CSV_String*)values[col])[row];
+#endif
+  CSV_String str;
+  str.s = ((char**)values[col])[row];
+  if (!str.s)
+    str.s = ""; // string that couldn't be stored
+  str.len = strlen(str.s);
+  return str;
+}
+
+const char * CSV_Parser::getTypeName(char type_specifier, bool is_unsigned) {
+  if (is_unsigned) {
+    switch(type_specifier){
+        case 'L': return "uint32_t";
+        case 'd': return "uint16_t";
+        case 'c': return "uint8_t";
+        case 'x': return "hex (uint32_t)"; // hex input, but it's stored as int32_t
+        case 'q': return "fixed-point (uint32_t)";
+    }
+  }
+  
+  switch(type_specifier){
+      case 's': return "char*";          
+      case 'f': return "float";
+      case 'L': return "int32_t";
+      case 'd': return "int16_t";
+      case 'c': return "char";
+      case 'x': return "hex (int32_t)"; // hex input, but it's stored as int32_t
+      case 'q': return "fixed-point (int32_t)";
+      case '-': return "-";
+      case   0: return "-";
+      default : return "unknown";
+  }
+}
+
+void CSV_Parser::saveNewValue(const ParsedValue & val, int row, int col) {
+  ColumnStore store = column_store[col];
+  if (!store)
+    return;
+#ifdef CSV_PARSER_ENABLE_STATS
+  StatsTime start = statsTime();
+  store(*this, val, row, col);
+  StatsTime duration = statsTime() - start;
+  if (fmt[col] == 's')
+    store_time += duration;
+  else
+    convert_time += duration;
+#else
+  store(*this, val, row, col);
+#endif
+}
+
+CSV_Parser::ColumnStore CSV_Parser::getColumnStore(char type_specifier, bool is_unsigned) {
+  /*  If at this point type_specifier is 's' or 'f' and is_unsigned is true, then format was probably invalid. 
+      Only 'L', 'd', 'c', 'x' values could be preceded with 'u' (and be stored as unsigned types).  */
+  switch (type_specifier) {
+    case 's': return storeString;
+    case 'f': return storeFloat;
+    case 'L': return is_unsigned ? storeInteger<uint32_t, 10> : storeInteger<int32_t, 10>;
+    case 'd': return is_unsigned ? storeInteger<uint16_t, 10> : storeInteger<int16_t, 10>;
+    case 'c': return is_unsigned ? storeInteger<uint8_t, 10>  : storeInteger<int8_t, 10>;
+    case 'x': return is_unsigned ? storeInteger<uint32_t, 16> : storeInteger<int32_t, 16>;
+    case 'q': return is_unsigned ? storeFixed<uint32_t> : storeFixed<int32_t>;
+    default : return 0;
+  }
+}
+
+void CSV_Parser::storeString(CSV_Parser & cp, const ParsedValue & val, int row, int col) {
+  // c-like string
+  char * str = cp.allocString(val.len);
+  if (str)
+    cp.copyValue(str, val);
+  ((char**)cp.values[col])[row] = str;
+}
+
+/*  Strings of rows passed to the row callback aren't copied, only their position within the row is saved (the row may be 
+    moved to leftover before it's complete). Values containing escaped quote chars are copied, because they must be unescaped.  */
+void CSV_Parser::storeStringView(CSV_Parser & cp, const ParsedValue & val, int row, int col) {
+  CSV_String & str = ((CSV_String*)cp.values[col])[row];
+  str.len = val.len;
+  if (val.quoted && memchr(val.s, cp.quote_char, val.len)) {
+    char * copy = cp.allocString(val.len);
+    if (copy)
+      cp.copyValue(copy, val);
+    else
+      str.len = 0;
+    str.s = copy;
+    cp.string_offsets[col] = -1;
+  } else {
+    cp.string_offsets[col] = val.s - cp.row_start;
+  }
+}
+
+#ifdef NON_ARDUINO
+/*  Strings of the file mapped by mapFile aren't copied (the mapping exists as long as the parser), except values 
+    containing escaped quote chars, which must be unescaped.  */
+void CSV_Parser::storeMappedString(CSV_Parser & cp, const ParsedValue & val, int row, int col) {
+  CSV_String & str = ((CSV_String*)cp.values[col])[row];
+  str.s = val.s;
+  str.len = val.len;
+  if (val.quoted && memchr(val.s, cp.quote_char, val.len)) {
+    char * copy = cp.allocString(val.len);
+    if (copy)
+      cp.copyValue(copy, val);
+    else
+      str.len = 0;
+    str.s = copy;
+  }
+}
+#endif
+
+/*  Strings of the row window are copied to the fixed size slot of the row (the value array of the column points to them).  */
+void CSV_Parser::storeWindowString(CSV_Parser & cp, const ParsedValue & val, int row, int col) {
+  ParsedValue truncated = val;
+  if (truncated.len > cp.window_string_len)
+    truncated.len = cp.window_string_len;
+  cp.copyValue(((char**)cp.values[col])[row], truncated);
+}
+
+void CSV_Parser::storeFloat(CSV_Parser & cp, const ParsedValue & val, int row, int col) {
+  if (!parseFloat(val.s, val.s + val.len, &((float*)cp.values[col])[row]))
+    cp.conversion_errors++;
+}
+
+/*  Integers are stored as signed/unsigned integers of 32/16/8 bits ("T"), "x" values are parsed as hex (base = 16). 
+    Signed hex values can use all bits, e.g. "FFFFFFFF" is stored as -1.  */
+template<typename T, uint8_t base>
+void CSV_Parser::storeInteger(CSV_Parser & cp, const ParsedValue & val, int row, int col) {
+  const uint8_t bits = sizeof(T) * 8;
+  const bool is_signed = (T)-1 < 0;
+  const uint32_t max_negative = is_signed ? (uint32_t)1 << (bits - 1) : 0;
+  const uint32_t max_positive = (!is_signed || base == 16) ? (uint32_t)0xFFFFFFFF >> (32 - bits) : max_negative - 1;
+
+  bool negative;
+  uint32_t magnitude;
+  if (!parseInteger(val.s, val.s + val.len, base, max_positive, max_negative, &negative, &magnitude))
+    cp.conversion_errors++;
+  ((T*)cp.values[col])[row] = (T)(negative ? 0 - magnitude : magnitude); // two's complement, so signed values are stored correctly too
+}
+
+/*  Fixed-point values ("q") are stored as int32_t/uint32_t ("T") holding the number of units of the last decimal place.  */
+template<typename T>
+void CSV_Parser::storeFixed(CSV_Parser & cp, const ParsedValue & val, int row, int col) {
+  const bool is_signed = (T)-1 < 0;
+  bool negative;
+  uint32_t magnitude;
+  if (!parseFixed(val.s, val.s + val.len, cp.fixed_scales[col], is_signed ? 0x7FFFFFFF : 0xFFFFFFFF, is_signed ? 0x80000000 : 0, &negative, &magnitude))
+    cp.conversion_errors++;
+  ((T*)cp.values[col])[row] = (T)(negative ? 0 - magnitude : magnitude);
+}
+
+/*  Instantiated for CSV_ParserT, which refers to them from the header (the linker drops the ones that aren't used).  */
+template void CSV_Parser::storeInteger<int32_t, 10>(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+template void CSV_Parser::storeInteger<uint32_t, 10>(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+template void CSV_Parser::storeInteger<int16_t, 10>(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+template void CSV_Parser::storeInteger<uint16_t, 10>(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+template void CSV_Parser::storeInteger<int8_t, 10>(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+template void CSV_Parser::storeInteger<uint8_t, 10>(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+template void CSV_Parser::storeInteger<int32_t, 16>(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+template void CSV_Parser::storeInteger<uint32_t, 16>(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+template void CSV_Parser::storeFixed<int32_t>(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+template void CSV_Parser::storeFixed<uint32_t>(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+
+/*  Integer of "size" bytes at values[i], sign-extended if it's signed (so it can be stored as any type at least as wide).  */
+static uint32_t loadIntegerBits(const void * values, int i, int8_t size, bool is_unsigned) {
+  switch (size) {
+    case 1:  return is_unsigned ? ((const uint8_t*)values)[i]  : (uint32_t)((const int8_t*)values)[i];
+    case 2:  return is_unsigned ? ((const uint16_t*)values)[i] : (uint32_t)((const int16_t*)values)[i];
+    default: return ((const uint32_t*)values)[i];
+  }
+}
+
+static void storeIntegerBits(void * values, int i, int8_t size, uint32_t bits) {
+  switch (size) {
+    case 1:  ((uint8_t*)values)[i] = bits; break;
+    case 2:  ((uint16_t*)values)[i] = bits; break;
+    default: ((uint32_t*)values)[i] = bits; break;
+  }
+}
+
+/*  Auto integers are parsed as 32-bit values, the column is widened before storing a value that doesn't fit its current type. 
+    If the column holds negative values and values above 2147483647 at the same time, the latter are saturated (int32_t is used).  */
+void CSV_Parser::storeAutoInteger(CSV_Parser & cp, const ParsedValue & val, int row, int col) {
+  bool negative;
+  uint32_t magnitude;
+  if (!parseInteger(val.s, val.s + val.len, 10, 0xFFFFFFFF, 0x80000000, &negative, &magnitude))
+    cp.conversion_errors++;
+
+  uint32_t & max_magnitude = negative ? cp.auto_columns[col].max_negative : cp.auto_columns[col].max_positive;
+  if (magnitude > max_magnitude) {
+    uint32_t previous = max_magnitude;
+    max_magnitude = magnitude;
+    if (!cp.fitAutoColumn(col)) {
+      max_magnitude = previous; // wider values couldn't be allocated, the value is truncated
+      cp.conversion_errors++;
+    }
+  }
+  int8_t size = getTypeSize(cp.fmt[col]);
+  if (!negative && magnitude > 0x7FFFFFFF && !cp.is_fmt_unsigned[col] && size == sizeof(int32_t)) {
+    magnitude = 0x7FFFFFFF;
+    cp.conversion_errors++;
+  }
+  storeIntegerBits(cp.values[col], row, size, negative ? 0 - magnitude : magnitude);
+}
+
+/*  Chooses the narrowest type holding all values seen so far in the auto column and widens the column to it if needed. 
+    The chosen type is never narrower than the current one, because the magnitudes only grow.  */
+bool CSV_Parser::fitAutoColumn(int col) {
+  const AutoColumn & range = auto_columns[col];
+  bool is_unsigned = range.max_negative == 0;
+  char type;
+  if (is_unsigned)
+    type = range.max_positive <= 0xFF ? 'c' : range.max_positive <= 0xFFFF ? 'd' : 'L';
+  else if (range.max_positive <= 0x7F && range.max_negative <= 0x80)
+    type = 'c';
+  else if (range.max_positive <= 0x7FFF && range.max_negative <= 0x8000)
+    type = 'd';
+  else
+    type = 'L';
+  if (type == fmt[col] && is_unsigned == (bool)is_fmt_unsigned[col])
+    return true;
+  return widenColumn(col, type, is_unsigned);
+}
+
+/*  Changes the type of the integer column to one that is at least as wide, stored values are converted in place 
+    (starting from the last one, so wider values don't overwrite the ones that weren't converted yet).  */
+bool CSV_Parser::widenColumn(int col, char type_specifier, bool is_unsigned) {
+  int8_t old_size = getTypeSize(fmt[col]);
+  int8_t new_size = getTypeSize(type_specifier);
+  if (new_size > old_size) {
+    void * new_values = reallocMemory(values[col], (size_t)rows_capacity * new_size);
+    if (!new_values)
+      return false;
+    values[col] = new_values;
+  }
+  bool was_unsigned = is_fmt_unsigned[col];
+  for (int row = rows_count - 1; row >= 0; row--) {
+    uint32_t bits = loadIntegerBits(values[col], row, old_size, was_unsigned);
+    if (was_unsigned && !is_unsigned && new_size == sizeof(int32_t) && bits > 0x7FFFFFFF) {
+      bits = 0x7FFFFFFF; // values above 2147483647 can't be stored together with negative ones
+      conversion_errors++;
+    }
+    storeIntegerBits(values[col], row, new_size, bits);
+  }
+  fmt[col] = type_specifier;
+  is_fmt_unsigned[col] = is_unsigned;
+  return true;
+}
+
+/*  Adds the value to the running statistics of the column (mean and m2 are updated with Welford's algorithm).  */
+void CSV_Parser::storeAggregate(CSV_Parser & cp, const ParsedValue & val, int /*row*/, int col) {
+  if (skipSpaces(val.s, val.s + val.len) == val.s + val.len)
+    return; // empty values aren't included
+  ColumnAggregate & aggregate = cp.aggregates[col];
+  aggregate.store(cp, val, 0, col);
+  double x;
+  if (cp.fmt[col] == 'f') {
+    x = ((float*)cp.values[col])[0];
+  } else {
+    uint32_t bits = loadIntegerBits(cp.values[col], 0, getTypeSize(cp.fmt[col]), cp.is_fmt_unsigned[col]);
+    x = cp.is_fmt_unsigned[col] ? (double)bits : (double)(int32_t)bits;
+    if (cp.fmt[col] == 'q')
+      x /= pow(10.0, cp.fixed_scales[col]); // statistics of fixed-point column are in its units
+  }
+
+  CSV_Aggregate & result = aggregate.result;
+  if (result.count++ == 0 || x < result.min)
+    result.min = x;
+  if (result.count == 1 || x > result.max)
+    result.max = x;
+  result.sum += x;
+  double delta = x - result.mean;
+  result.mean += delta / result.count;
+  result.m2 += delta * (x - result.mean);
+}
+
+/*  Copies the value into the field of the struct of the row.  */
+void CSV_Parser::storeBound(CSV_Parser & cp, const ParsedValue & val, int row, int col) {
+  BoundColumn & bound = cp.bound_columns[col];
+  bound.store(cp, val, 0, col);
+  char * field = cp.struct_array + (size_t)row * cp.struct_size + bound.offset;
+  // constant sizes let the compiler replace memcpy calls with single moves (fields may be unaligned, so plain assignment isn't used)
+  switch (bound.size) {
+    case 1: memcpy(field, cp.values[col], 1); break;
+    case 2: memcpy(field, cp.values[col], 2); break;
+    case 4: memcpy(field, cp.values[col], 4); break;
+    case 8: memcpy(field, cp.values[col], 8); break;
+    default: memcpy(field, cp.values[col], bound.size); break;
+  }
+}
+
+void CSV_Parser::releaseColumnValues(int col) {
+  if (rows_capacity > 1) {
+    // values reserved before aren't needed
+    if (void * new_values = reallocMemory(values[col], getTypeSize(fmt[col])))
+      values[col] = new_values;
+  }
+}
+
+void CSV_Parser::printKeys(Stream &ser) {
+  #ifndef NON_ARDUINO
+  ser.println("Keys:");
+  for (int col = 0; col < cols_count; col++) 
+    ser.println(String(col) + ". Key = " + String(keys[col] ? keys[col] : "unused"));
+  #else 
+    (void)ser; // keys are printed to stdout
+    printf("Keys:\n");
+  for (int col = 0; col < cols_count; col++)
+    printf("%d. Key = %s\n", col, keys[col] ? keys[col] : "unused");
+  #endif
+}
+
+bool CSV_Parser::reserve(int rows) {
+  if (rows <= rows_capacity || row_callback || window_size)
+    return true; // rows passed to the row callback aren't stored, capacity of the row window is fixed
+
+  if (struct_array && rows > struct_capacity) {
+    if (struct_array_owned) {
+      char * new_structs = (size_t)rows <= (size_t)-1 / struct_size ? (char*)reallocMemory(struct_array, (size_t)rows * struct_size) : 0;
+      if (!new_structs)
+        return false;
+      struct_array = new_structs;
+      struct_capacity = rows;
+    } else if (rows_capacity < struct_capacity) {
+      rows = struct_capacity; // values arrays don't have to hold more rows than the array supplied by the user
+    } else {
+      out_of_memory = true; // array supplied by the user is full
+      return false;
+    }
+  }
+  for (int col = 0; col < cols_count; col++) {
+    int8_t type_size = valueSize(col);
+    if (!type_size)
+      continue;
+    void * new_values = (size_t)rows <= (size_t)-1 / type_size ? reallocMemory(values[col], (size_t)rows * type_size) : 0;
+    if (!new_values)
+      return false; // rows_capacity is left unchanged, so it remains valid for all columns
+    values[col] = new_values;
+  }
+  rows_capacity = rows;
+  return true;
+}
+
+void CSV_Parser::shrinkToFit() {
+  int rows = rows_count > 0 ? rows_count : 1;
+  if (rows >= rows_capacity || row_callback || window_size)
+    return;
+
+  for (int col = 0; col < cols_count; col++) {
+    int8_t type_size = valueSize(col);
+    if (!type_size)
+      continue;
+    if (void * new_values = reallocMemory(values[col], (size_t)rows * type_size))
+      values[col] = new_values;
+  }
+  if (struct_array_owned) {
+    if (char * new_structs = (char*)reallocMemory(struct_array, (size_t)rows * struct_size)) {
+      struct_array = new_structs;
+      struct_capacity = rows;
+    }
+  }
+  rows_capacity = rows;
+}
+
+/*  Grows all column arrays by half of their current capacity when the next row would not fit.
+    Growing geometrically (instead of by 1 row) avoids copying all values on every new row and fragments the heap much less.  */
+bool CSV_Parser::ensureRowsCapacity() {
+  if (rows_count < rows_capacity)
+    return true;
+  if (rows_capacity == INT_MAX) {
+    out_of_memory = true; // rows are counted by int
+    return false;
+  }
+  int growth = rows_capacity / 2 + 1;
+  int rows = rows_capacity <= INT_MAX - growth ? rows_capacity + growth : INT_MAX;
+#ifdef CSV_PARSER_ENABLE_STATS
+  StatsTime start = statsTime();
+  bool reserved = reserve(rows);
+  store_time += statsTime() - start;
+  return reserved;
+#else
+  return reserve(rows);
+#endif
+}
+
+int CSV_Parser::getColumnsCount() { return cols_count; }
+int CSV_Parser::getRowsCount() { return rows_count; } // excluding header
+
+uint32_t CSV_Parser::getOldestRowIndex() { return window_size ? rows_parsed - rows_count : 0; }
+uint32_t CSV_Parser::getNewestRowIndex() { return getOldestRowIndex() + rows_count - 1; }
+uint32_t CSV_Parser::getDroppedRowsCount() { return getOldestRowIndex(); }
+
+int CSV_Parser::getRowPosition(uint32_t row_index) {
+  uint32_t oldest = getOldestRowIndex();
+  if (row_index < oldest || row_index - oldest >= (uint32_t)rows_count)
+    return -1;
+  if (!window_size)
+    return row_index;
+  // the row parsed "distance" rows ago is stored "distance" positions before the next row (in circular order)
+  int distance = rows_parsed - row_index;
+  return (window_next + window_size + 1 - distance) % (window_size + 1);
+}
+
+bool CSV_Parser::setRowWindow(int rows, int max_string_len) {
+  if (rows < 1 || max_string_len < 0 || window_size || row_callback || struct_array)
+    return false;
+  // one slot more than the number of kept rows, so the row being parsed never overwrites a kept row 
+  // (it may be read between chunks, while the row isn't complete yet, and the row may be rejected by a filter)
+  int slots = rows + 1;
+  int string_cols = 0;
+  for (int col = 0; col < cols_count; col++)
+    if (fmt[col] == 's')
+      string_cols++;
+  freeMemory(window_strings); // in case the previous call failed
+  window_strings = 0;
+  if (string_cols) {
+    window_strings = (char*)allocMemory((size_t)slots * string_cols * (max_string_len + 1));
+    if (!window_strings)
+      return false;
+  }
+  for (int col = 0; col < cols_count; col++) {
+    int8_t type_size = valueSize(col);
+    if (!type_size)
+      continue;
+    void * new_values = reallocMemory(values[col], (size_t)slots * type_size);
+    if (!new_values)
+      return false;
+    values[col] = new_values;
+  }
+
+  char * slot = window_strings;
+  for (int col = 0; col < cols_count; col++) {
+    if (fmt[col] != 's')
+      continue;
+    for (int row = 0; row < slots; row++) {
+      ((char**)values[col])[row] = slot;
+      *slot = 0;
+      slot += max_string_len + 1;
+    }
+    column_store[col] = storeWindowString;
+  }
+  window_size = rows;
+  rows_capacity = slots;
+  window_string_len = max_string_len;
+  return true;
+}
+
+/*  Get values pointer given column name (key in other words)  */
+void * CSV_Parser::operator [] (const char *key) { 
+  int col = findColumn(key);
+  return col >= 0 ? values[col] : (void*)0;
+}
+
+void * CSV_Parser::operator [] (const CSV_Column & column) { return column.index >= 0 && column.index < cols_count ? values[column.index] : (void*)0; }
+
+CSV_Column CSV_Parser::getColumn(const char * key) { return getColumn(findColumn(key)); }
+
+CSV_Column CSV_Parser::getColumn(int col_index) {
+  CSV_Column column = {-1, 0, false, 0};
+  if (col_index >= 0 && col_index < cols_count) {
+    column.index = col_index;
+    column.type = fmt[col_index];
+    column.is_unsigned = is_fmt_unsigned[col_index];
+    column.scale = fmt[col_index] == 'q' ? fixed_scales[col_index] : 0;
+  }
+  return column;
+}
+
+/*  FNV-1a hash of column names.  */
+static uint32_t hashKey(const char * key) {
+  uint32_t hash = 2166136261UL;
+  while (*key) {
+    hash ^= (uint8_t)*key++;
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+void CSV_Parser::buildKeyIndex() {
+  if (!has_header || key_index)
+    return;
+  int size = 4;
+  while (size < cols_count * 2)
+    size <<= 1;
+  key_index = (int16_t*)allocMemory(size * sizeof(int16_t));
+  if (!key_index)
+    return;
+  memset(key_index, 0, size * sizeof(int16_t));
+  key_index_size = size;
+
+  // columns are inserted in order, so if keys repeat then the first matching column is found (like with linear search)
+  for (int col = 0; col < cols_count; col++) {
+    if (!keys[col])
+      continue;
+    int slot = hashKey(keys[col]) & (size - 1);
+    while (key_index[slot])
+      slot = (slot + 1) & (size - 1);
+    key_index[slot] = col + 1;
+  }
+}
+
+/*  Returns index of the column with the given key, or -1 if there's none.  */
+int CSV_Parser::findColumn(const char * key) {
+  if (!key_index) {
+    for (int col = 0; col < cols_count; col++) 
+      if (keys[col] && !strcmp(keys[col], key))
+        return col;
+    return -1;
+  }
+  for (int slot = hashKey(key) & (key_index_size - 1); key_index[slot]; slot = (slot + 1) & (key_index_size - 1)) {
+    int col = key_index[slot] - 1;
+    if (!strcmp(keys[col], key))
+      return col;
+  }
+  return -1;
+}
+
+/*  Get values pointer given column index (0 being the first column)  */
+void * CSV_Parser::operator [] (int index) { return index < cols_count ? values[index] : (void*)0; }
+
+/*  Prints fixed-point value with all its decimal places (e.g. 1205 with scale 3 as "1.205", -5 with scale 2 as "-0.05").  */
+static void printFixed(Stream &ser, bool negative, uint32_t magnitude, uint8_t scale) {
+  uint32_t divisor = 1;
+  for (int i = 0; i < scale; i++)
+    divisor *= 10;
+  if (negative)
+    ser.print('-');
+  ser.print(magnitude / divisor, DEC);
+  if (!scale)
+    return;
+  ser.print('.');
+  uint32_t fraction = magnitude % divisor;
+  for (uint32_t d = divisor / 10; d > 1 && fraction < d; d /= 10)
+    ser.print('0'); // leading zeros of the fraction
+  ser.print(fraction, DEC);
+}
+
+/*  Prints column names, their types and all stored values.  */
+void CSV_Parser::print(Stream &ser) {
+  ser.println("CSV_Parser content:");
+  ser.print("rows_count = ");
+  ser.print(rows_count, DEC);
+  ser.print(", cols_count = ");
+  ser.println(cols_count, DEC);
+  if (has_header) {
+    ser.println("   Header:");
+    ser.print("      ");
+    for (int col = 0; col < cols_count; col++) { 
+      ser.print(keys[col] ? keys[col] : " - "); if(col == cols_count - 1) { continue; }
+      ser.print(" | ");
+    }
     ser.println();
   } else {
     ser.println("(No header)");
@@ -405,22 +1898,45 @@ void CSV_Parser::print(Stream &ser) {
   for (int i = 0; i < rows_count; i++) {
     ser.print("      ");
     for (int j = 0; j < cols_count; j++) {  
-      if (is_fmt_unsigned[j]) {
+      void * column = values[j];
+      int row = window_size ? getRowPosition(getOldestRowIndex() + i) : i; // kept rows of the window are printed from the oldest one
+      if (isBound(j)) {
+        column = struct_array + (size_t)i * struct_size + bound_columns[j].offset; // value is in the struct of the row
+        row = 0;
+      }
+      if (isAggregated(j)) {
+        ser.print('-'); // only running statistics of the column are kept
+      } else if (is_fmt_unsigned[j]) {
         switch(fmt[j]){
-            case 'L': ser.print( ((uint32_t*)values[j])[i]  , DEC); break;          
-            case 'd': ser.print( ((uint16_t*)values[j])[i]  , DEC); break;
-            case 'c': ser.print( ((uint8_t*) values[j])[i]  , DEC); break;
-            case 'x': ser.print( ((uint32_t*)values[j])[i]  , HEX); break;
+            case 'L': ser.print( ((uint32_t*)column)[row]  , DEC); break;          
+            case 'd': ser.print( ((uint16_t*)column)[row]  , DEC); break;
+            case 'c': ser.print( ((uint8_t*) column)[row]  , DEC); break;
+            case 'x': ser.print( ((uint32_t*)column)[row]  , HEX); break;
+            case 'q': printFixed(ser, false, ((uint32_t*)column)[row], fixed_scales[j]); break;
             default : ser.print("Invalid unsigned type"); break;
         }
       } else {
         switch(fmt[j]){
-            case 's': ser.print( ((char**)  values[j])[i] );       break;
-            case 'f': ser.print( ((float*)  values[j])[i] );       break;
-            case 'L': ser.print( ((int32_t*)values[j])[i]  , DEC); break;          
-            case 'd': ser.print( ((int16_t*)values[j])[i]  , DEC); break;
-            case 'c': ser.print( ((char*)   values[j])[i]  , DEC); break;
-            case 'x': ser.print( ((int32_t*)values[j])[i]  , HEX); break;
+            case 's': 
+#ifdef NON_ARDUINO
+              if (string_views) {
+                CSV_String str = ((CSV_String*)column)[row];
+                for (int k = 0; k < str.len; k++)
+                  ser.write(str.s[k]);
+                break;
+              }
+#endif
+              ser.print( ((char**)  column)[row] );       break;
+            case 'f': ser.print( ((float*)  column)[row] );       break;
+            case 'L': ser.print( ((int32_t*)column)[row]  , DEC); break;          
+            case 'd': ser.print( ((int16_t*)column)[row]  , DEC); break;
+            case 'c': ser.print( ((char*)   column)[row]  , DEC); break;
+            case 'x': ser.print( ((int32_t*)column)[row]  , HEX); break;
+            case 'q': {
+              int32_t value = ((int32_t*)column)[row];
+              printFixed(ser, value < 0, value < 0 ? 0 - (uint32_t)value : value, fixed_scales[j]);
+              break;
+            }
             case '-': ser.print('-'); break;
             case   0: ser.print('-'); break;
         }
@@ -428,85 +1944,357 @@ void CSV_Parser::print(Stream &ser) {
       if(j == cols_count - 1) { continue; }
       ser.print(" | ");
     }
-    ser.println();
+    ser.println();
+  }
+  uint32_t sum = 0;
+  for (int col = 0; col < cols_count; col++)
+    sum += valueSize(col) * rows_count + (has_header && fmt[col] != '-' ? strlen(keys[col]) + 1 : 0);
+  if (struct_array)
+    sum += struct_size * rows_count;
+  ser.print("Memory occupied by values themselves = "); 
+  ser.println(sum, DEC);
+  ser.print("sizeof(CSV_Parser) = ");
+  ser.println(sizeof(CSV_Parser), DEC);
+#ifdef CSV_PARSER_ENABLE_STATS
+  CSV_Stats parser_stats = getStats();
+  ser.print("Memory used by the parser = ");
+  ser.print(parser_stats.memory_used, DEC);
+  ser.print(", peak = ");
+  ser.println(parser_stats.memory_peak, DEC);
+#endif
+}
+
+bool CSV_Parser::reserveLeftover(size_t extra_len) {
+  size_t unparsed_len = leftover_len - leftover_start;
+  size_t needed = unparsed_len + extra_len + 1;
+
+  if (leftover_len + extra_len + 1 <= leftover_capacity)
+    return true;
+
+  // Compacting is cheap when most of the buffer holds already parsed chars, 
+  // otherwise it would be repeated on every append (making supply of long values quadratic).
+  if (needed <= leftover_capacity && leftover_start >= leftover_capacity / 2) {
+    memmove(leftover, leftover + leftover_start, unparsed_len + 1);
+    leftover_start = 0;
+    leftover_len = unparsed_len;
+    return true;
+  }
+
+  size_t new_capacity = leftover_capacity ? leftover_capacity * 2 : 32;
+  while (new_capacity < needed)
+    new_capacity *= 2;
+
+  if (leftover_start) {
+    memmove(leftover, leftover + leftover_start, unparsed_len + 1);
+    leftover_start = 0;
+    leftover_len = unparsed_len;
+  }
+  char * new_leftover = (char*)reallocMemory(leftover, new_capacity);
+  if (!new_leftover)
+    return false;
+  leftover = new_leftover;
+  leftover_capacity = new_capacity;
+  leftover[leftover_len] = 0;
+  return true;
+}
+
+// If there's no leftover and first supplied char is '\n' then it could be the case that the last char was "\r",
+// so '\n' should be ignored. The same applies to empty lines (consecutive new line chars are skipped together, 
+// also when they're split between chunks).
+const char * CSV_Parser::skipIgnoredDelimChar(const char *s, const char *end) {
+  if (ignore_next_delimchar && s < end) {
+    s += spanNewLines(s, end);
+    // the chunk may consist of new line chars only
+    ignore_next_delimchar = s == end;
+  }
+  return s;
+}
+
+/*  Skips the rest of the row (up to and including new line chars), returns pointer to the first char of the next row.  
+    If the end of the row isn't found (e.g. the row continues in the next chunk) it returns "end" and "skipping_row" stays set.  
+    Values aren't parsed, a new line is found with a few memchr calls. Like in parseStringValue, only a quote char at the 
+    start of a value (after a delimiter) starts a quoted value, then new line chars up to the ending quote are a part of it.  */
+const char * CSV_Parser::skipRow(const char *s, const char *end) {
+  while (s < end) {
+    if (skip_in_quotes) {
+      const char * quote = (const char*)memchr(s, quote_char, end - s);
+      if (!quote)
+        return end;
+      skip_in_quotes = skip_in_value = false; // a value may follow the ending quote without a delimiter
+      s = quote + 1;
+      continue;
+    }
+    const char * new_line = (const char*)memchr(s, '\n', end - s);
+    const char * cr = (const char*)memchr(s, '\r', (new_line ? new_line : end) - s);
+    if (cr)
+      new_line = cr;
+    const char * quote = (const char*)memchr(s, quote_char, (new_line ? new_line : end) - s);
+    if (quote) {
+      if (quote == s ? !skip_in_value : *(quote - 1) == delimiter)
+        skip_in_quotes = true;
+      else
+        skip_in_value = true; // the quote char is a part of an unquoted value
+      s = quote + 1;
+      continue;
+    }
+    if (!new_line) {
+      skip_in_value = *(end - 1) != delimiter;
+      return end;
+    }
+    skipping_row = skip_in_value = false;
+    return new_line + spanNewLines(new_line, end);
+  }
+  return end;
+}
+
+void CSV_Parser::endRow() {
+  current_col = 0;
+#ifdef CSV_PARSER_ENABLE_STATS
+  if (header_parsed && !rows_to_skip)
+    stats.rows_parsed++;
+#endif
+  if (!header_parsed) { header_parsed = true; buildKeyIndex(); }
+  else if (rows_to_skip) rows_to_skip--; // row preceding the rows read by readRows
+  else if (row_dropped || row_rejected) row_dropped = row_rejected = false; // row that didn't fit in memory or didn't match filters isn't counted
+  else {
+    rows_accepted++;
+    if (row_callback) visitRow();
+    else if (!window_size) rows_count++;
+    else {
+      // the completed row is kept, when the window is full the oldest row stops being kept (its slot is used by the next row)
+      rows_parsed++;
+      if (rows_count < window_size) rows_count++;
+      if (++window_next == window_size + 1) window_next = 0;
+    }
   }
-  uint32_t sum = 0;
-  for (int col = 0; col < cols_count; col++)
-    sum += getTypeSize(fmt[col]) * rows_count + (has_header && fmt[col] != '-' ? strlen(keys[col]) + 1 : 0);
-  ser.print("Memory occupied by values themselves = "); 
-  ser.println(sum, DEC);
-  ser.print("sizeof(CSV_Parser) = ");
-  ser.println(sizeof(CSV_Parser), DEC);
+  if (rows_to_skip)
+    skipping_row = true; // the next row is skipped too
+  if (column_filters)
+    markRowStrings();
 }
 
-void CSV_Parser::supplyChunk(const char *s) {
-  whole_csv_supplied = false;
-  
-  static bool ignore_next_delimchar = false;
+/*  Passes the complete row to the row callback. Values of the row are stored as the first row of values arrays.  */
+void CSV_Parser::visitRow() {
+  for (int col = 0; col < cols_count; col++)
+    if (fmt[col] == 's' && string_offsets[col] >= 0)
+      ((CSV_String*)values[col])->s = row_start + string_offsets[col];
+  CSV_Row row(*this, rows_visited++);
+#ifdef CSV_PARSER_ENABLE_STATS
+  StatsTime start = statsTime();
+  row_callback(row, row_callback_data);
+  callback_time += statsTime() - start;
+#else
+  row_callback(row, row_callback_data);
+#endif
+  freeStrings(true); // copied strings of the row aren't needed anymore
+}
 
-  if (leftover) {
-    int leftover_len = strlen(leftover);
-	
-    // If there's no leftover and first supplied char is '\n' then it could be the case that the last char was "\r",
-    // so '\n' should be ignored.
-    // The same applies to situation where " (quote char) was previously received and the supplied char is '\r'
-    if (leftover_len == 0 && ignore_next_delimchar && (*s == '\n' || *s == '\r' || *s == delimiter)) {
-      if(*s != '\r')
-        ignore_next_delimchar = false;
-      s++;
+/*  Returns whether the value should be stored. If it doesn't match any filter of its column, the row is rejected.  */
+bool CSV_Parser::acceptValue(const ParsedValue & val, int col) {
+  if (row_rejected)
+    return false; // values following the rejected one (e.g. when the row has less values than columns)
+  for (ColumnFilter * filter = column_filters[col]; filter; filter = filter->next) {
+    if (!matchesFilter(*filter, val, col)) {
+      rejectRow();
+      return false;
     }
-    
-    int s_len = strlen(s);
-    //debug_serial->println("leftover_len = " + String(leftover_len) + ", s_len = " + String(s_len));
-    leftover = (char*)realloc(leftover, leftover_len + s_len + 1);
-	
-    //if (!leftover) 
-    //	debug_serial->println("leftover realloc failed");
-    strcat(leftover, s);
-    s = leftover;
-    //debug_serial->println("merged leftover = " + String(leftover));
   }
+  return true;
+}
+
+bool CSV_Parser::matchesFilter(ColumnFilter & filter, const ParsedValue & val, int col) {
+  int result;
+  if (fmt[col] == 's' || fmt[col] == '-') {
+    result = compareValue(val, filter.value());
+  } else {
+    double number;
+    if (!convertNumber(val.s, val.s + val.len, col, &number))
+      return false;
+    result = (number > filter.number) - (number < filter.number);
+  }
+  switch (filter.op) {
+    case CSV_EQUAL:            return result == 0;
+    case CSV_NOT_EQUAL:        return result != 0;
+    case CSV_LESS:             return result < 0;
+    case CSV_LESS_OR_EQUAL:    return result <= 0;
+    case CSV_GREATER:          return result > 0;
+    case CSV_GREATER_OR_EQUAL: return result >= 0;
+    default:                   return false;
+  }
+}
+
+/*  Converts the number the same way as values of the column are converted (without saturating it to the column type), 
+    hex values of signed "x" columns can use all bits (e.g. "FFFFFFFF" is -1), fixed-point values stay multiplied by 10^scale.  */
+bool CSV_Parser::convertNumber(const char * s, const char * end, int col, double * number) {
+  if (skipSpaces(s, end) == end)
+    return false; // empty
+  if (fmt[col] == 'f') {
+    float f;
+    if (!parseFloat(s, end, &f))
+      return false;
+    *number = f;
+    return true;
+  }
+  bool negative;
+  uint32_t magnitude;
+  bool converted = fmt[col] == 'q' ? parseFixed(s, end, fixed_scales[col], 0xFFFFFFFF, 0xFFFFFFFF, &negative, &magnitude) :
+                                     parseInteger(s, end, fmt[col] == 'x' ? 16 : 10, 0xFFFFFFFF, 0xFFFFFFFF, &negative, &magnitude);
+  if (!converted)
+    return false;
+  if (fmt[col] == 'x' && !is_fmt_unsigned[col] && !negative)
+    *number = (int32_t)magnitude;
+  else
+    *number = negative ? -(double)magnitude : (double)magnitude;
+  return true;
+}
+
+/*  Compares the value (as if quote chars were unescaped) with the string, like strcmp.  */
+int CSV_Parser::compareValue(const ParsedValue & val, const char * s) {
+  const char * v = val.s;
+  for (int i = 0; i < val.len; i++, v++, s++) {
+    if (*v != *s)
+      return *s ? (unsigned char)*v - (unsigned char)*s : 1;
+    if (val.quoted && *v == quote_char)
+      v++; // 2 adjacent quote chars stand for 1
+  }
+  return *s ? -1 : 0;
+}
+
+/*  Releases strings stored for the row so far (they're the most recently allocated ones), so rejected rows don't take memory.  */
+void CSV_Parser::rejectRow() {
+  row_rejected = true;
+  rows_rejected++;
+  while (string_slabs != row_slab) {
+    StringSlab * next = string_slabs->next;
+    freeMemory(string_slabs);
+    string_slabs = next;
+  }
+  if (!string_slabs)
+    return;
+  while (string_slabs->next != row_slab_next) {
+    StringSlab * oversized = string_slabs->next;
+    string_slabs->next = oversized->next;
+    freeMemory(oversized);
+  }
+  string_slabs->used = row_slab_used;
+}
 
+const char * CSV_Parser::parseChunk(const char *s, const char *end) {
+#if defined(CSV_PARSER_SIMD)
+  scan_block = 0; // masks of previously parsed data are not valid anymore
+#endif
   int chars_occupied = 0;
-  char * val = 0;
-  while ((val = parseStringValue(s, &chars_occupied))) {
-    // debug_serial->println("rows_count = " + String(rows_count) + ", current_col = " + String(current_col) + ", val = " + String(val));
-    if (fmt[current_col] != '-') {
+  ParsedValue val;
+  row_start = s;
+  s += row_resume;
+#ifdef CSV_PARSER_ENABLE_STATS
+  StatsTime start = statsTime();
+  const char * begin = s;
+#endif
+  while (true) {
+    if (skipping_row) {
+      if (s == end)
+        break; // nothing to skip in this chunk (e.g. the next row skipped by readRows), so ignore_next_delimchar is kept
+      s = skipRow(s, end);
+      if (skipping_row) {
+        // the rest of the row is in the next chunk
+        ignore_next_delimchar = false;
+        break;
+      }
+      endRow();
+      row_start = s;
+    } else if (parseStringValue(s, end, &chars_occupied, &val)) {
+#ifdef CSV_PARSER_ENABLE_STATS
+      stats.values_parsed++;
+#endif
+      // debug_serial->println("rows_count = " + String(rows_count) + ", current_col = " + String(current_col) + ", val = " + String(val));
       if (!header_parsed) {
-        keys[current_col] = strdup_trimmed(val);
-      } else {
+        if (fmt[current_col] != '-')
+          keys[current_col] = strdup_trimmed(val);
+      } else if (column_filters && !acceptValue(val, current_col)) {
+        // the row is rejected, its remaining values are skipped
+      } else if (fmt[current_col] != '-') {
         //mem.check("values[" + String(current_col) + "]");
-        if (rows_count > 0)
-          values[current_col] = (char*)realloc(values[current_col], (rows_count+1) * getTypeSize(fmt[current_col])); 
-        saveNewValue(val, fmt[current_col], rows_count, current_col, is_fmt_unsigned[current_col]);
+        if (ensureRowsCapacity())
+          saveNewValue(val, newRowPosition(), current_col);
+        else
+          row_dropped = true;
       }
+      s += chars_occupied;
+      //debug_serial->println("chars_occupied = " + String(chars_occupied));
+      chars_occupied = 0;
+
+      if (++current_col == cols_count) {
+        endRow();
+        row_start = s;
+      } else if ((current_col > last_used_col || row_rejected) && *(s-1) != '\n' && *(s-1) != '\r')
+        skipping_row = true; // remaining values of the row aren't used
+    } else {
+      break;
     }
-    
-    if (++current_col == cols_count) {
-      current_col = 0;
-      if (!header_parsed) header_parsed = true;
-      else rows_count++;
-    }
-    free(val);
-    s += chars_occupied;
-	//debug_serial->println("chars_occupied = " + String(chars_occupied));
-    chars_occupied = 0;
 	
-	if (!(*s) && (*(s-1) == quote_char || *(s-1) == '\r'))
+	if (s == end && (*(s-1) == '\r' || *(s-1) == '\n'))
 		ignore_next_delimchar = true;
 	else 
 		ignore_next_delimchar = false;
+
+    if (rows_limit && rows_count >= rows_limit)
+      break;
+  }
+#ifdef CSV_PARSER_ENABLE_STATS
+  stats.bytes_parsed += s - begin;
+  parse_time += statsTime() - start;
+#endif
+  if (!row_callback) {
+    row_resume = 0; // rows aren't kept, parsing continues from the returned position
+    return s;
+  }
+  // the incomplete row is kept as a whole, so strings of its already parsed values can be passed to the callback
+  row_resume = s - row_start;
+  return row_start;
+}
+
+void CSV_Parser::parseAppendedLeftover(size_t appended_len) {
+  whole_csv_supplied = false;
+
+  size_t appended_start = leftover_len;
+  leftover_len += appended_len;
+  leftover[leftover_len] = 0;
+  if (leftover_start + row_resume == appended_start)
+    row_resume = skipIgnoredDelimChar(leftover + appended_start, leftover + leftover_len) - (leftover + leftover_start);
+
+  // advancing the cursor is enough, parsed chars get discarded lazily by reserveLeftover
+  leftover_start = parseChunk(leftover + leftover_start, leftover + leftover_len) - leftover;
+  if (leftover_start == leftover_len)
+    leftover_start = leftover_len = 0;
+}
+
+void CSV_Parser::supplyChunk(const char *s) {
+  // Unparsed chars from previous chunks are merged with the new chunk, otherwise the new chunk is parsed 
+  // directly (without copying it) and only its unparsed ending is kept in leftover.
+  if (leftover_start != leftover_len) {
+    size_t s_len = strlen(s);
+    if (!reserveLeftover(s_len))
+      return;
+    memcpy(leftover + leftover_len, s, s_len + 1);
+    parseAppendedLeftover(s_len);
+    return;
   }
 
-  if (s != leftover) {
-	//Serial.println("if (*s && s != leftover) s = " + String(s));
-	//Serial.println("leftover = " + String(leftover));
-    int new_size = strlen(s);
-	  if (!leftover)
-		  leftover = (char*)malloc(new_size+1);
-	    memmove(leftover, s, new_size+1);
-      leftover = (char*)realloc(leftover, new_size + 1);   
-	//debug_serial->println("new_size = " + String(new_size) + ", new leftover = " + String(leftover));
+  whole_csv_supplied = false;
+  const char * end = s + strlen(s);
+  s = parseChunk(skipIgnoredDelimChar(s, end), end);
+  if (s != end) {
+    size_t new_size = end - s;
+    leftover_start = leftover_len = 0;
+    if (!reserveLeftover(new_size)) {
+      // the unparsed ending is dropped, so progress within it is forgotten too (like in resetParsing)
+      row_resume = 0;
+      scan_resume = scan_ending_quote = scan_escaped_quotes = 0;
+      return;
+    }
+    memcpy(leftover, s, new_size + 1);
+    leftover_len = new_size;
   }
 }
 
@@ -531,24 +2319,57 @@ CSV_Parser & CSV_Parser::operator << (char c) {
 }
 
 void CSV_Parser::parseLeftover() {
-  if (leftover) {
-    whole_csv_supplied = true;
-    int chars_occupied = 0;
-    if (char * val = parseStringValue(leftover, &chars_occupied)) {
-      if (fmt[current_col] != '-') {
-        if (rows_count > 0)
-          values[current_col] = realloc(values[current_col], (rows_count+1) * getTypeSize(fmt[current_col]));
-        saveNewValue(val, fmt[current_col], rows_count, current_col, is_fmt_unsigned[current_col]);  
-      }
-      if (++current_col == cols_count) {
-        current_col = 0;
-        rows_count++;
-      }
-      free(val);
+  // Nothing is left to parse if the last supplied value was followed by "\n" (unless the row ended with delimiter, which means that the last value is empty)
+  if (leftover_start == leftover_len && current_col == 0)
+    return;
+
+  const char * s = leftover ? leftover + leftover_start : "";
+  parseLastValue(s, leftover ? leftover + leftover_len : s);
+  freeMemory(leftover);
+  leftover = 0;
+  leftover_start = leftover_len = leftover_capacity = 0;
+}
+
+void CSV_Parser::parseLastValue(const char * s, const char * end) {
+  whole_csv_supplied = true;
+  int chars_occupied = 0;
+  ParsedValue val;
+  row_start = s;
+  s += row_resume;
+#ifdef CSV_PARSER_ENABLE_STATS
+  StatsTime start = statsTime();
+#endif
+#if defined(CSV_PARSER_SIMD)
+  scan_block = 0;
+#endif
+  if (skipping_row) {
+    // the last row didn't end with a new line, its remaining (unused) values were already skipped
+    skipping_row = skip_in_quotes = skip_in_value = false;
+    endRow();
+  } else if (parseStringValue(s, end, &chars_occupied, &val)) {
+#ifdef CSV_PARSER_ENABLE_STATS
+    stats.values_parsed++;
+    stats.bytes_parsed += chars_occupied;
+#endif
+    if (!header_parsed) {
+      if (fmt[current_col] != '-')
+        keys[current_col] = strdup_trimmed(val);
+    } else if (column_filters && !acceptValue(val, current_col)) {
+      // the row is rejected
+    } else if (fmt[current_col] != '-') {
+      if (ensureRowsCapacity())
+        saveNewValue(val, newRowPosition(), current_col);  
+      else
+        row_dropped = true;
     }
-    free(leftover);
-    leftover = 0;
+    if (++current_col == cols_count)
+      endRow();
   }
+  row_resume = 0;
+  scan_resume = scan_ending_quote = scan_escaped_quotes = 0;
+#ifdef CSV_PARSER_ENABLE_STATS
+  parse_time += statsTime() - start;
+#endif
 }
 
 // void CSV_Parser::setFeedRowParserCallback(std::function<char()> func) {
@@ -571,4 +2392,672 @@ void CSV_Parser::setFeedRowParserStrCallback(FeedRowParserStrCallback func) {
 
 void CSV_Parser::setRowParserFinishedCallback(RowParserFinishedCallback func) {
   this->rowParserFinished_callback = func;
-}
\ No newline at end of file
+}
+
+void CSV_Parser::setFillBufferCallback(FillBufferCallback func) {
+  this->fillBuffer_callback = func;
+}
+
+bool CSV_Parser::setRowCallback(CSV_RowCallback callback, void * user_data) {
+  if (struct_array || window_size)
+    return false;
+  if (!string_offsets) {
+    string_offsets = (int*)allocMemory(cols_count * sizeof(int));
+    if (!string_offsets)
+      return false;
+  }
+  for (int col = 0; col < cols_count; col++) {
+    if (fmt[col] != 's')
+      continue;
+    // only the current row is stored, so values arrays of strings don't have to grow anymore
+    void * new_values = reallocMemory(values[col], rows_capacity * sizeof(CSV_String));
+    if (!new_values)
+      return false;
+    values[col] = new_values;
+    column_store[col] = callback ? storeStringView : storeString;
+  }
+  row_callback = callback;
+  row_callback_data = user_data;
+  return true;
+}
+
+bool CSV_Parser::setColumnAggregate(int col) {
+  if (col < 0 || col >= cols_count || rows_count || rows_visited || rows_parsed || current_col)
+    return false;
+  if (!strchr("fLdcxq", fmt[col]) || isAutoColumn(col) || isBound(col))
+    return false;
+  for (int i = col + 1; column_filters && i < cols_count; i++)
+    if (column_filters[i])
+      return false; // values would be added before the row is rejected by the filter
+  if (isAggregated(col))
+    return true;
+  if (!aggregates) {
+    aggregates = (ColumnAggregate*)allocMemory(cols_count * sizeof(ColumnAggregate));
+    if (!aggregates)
+      return false;
+    memset(aggregates, 0, cols_count * sizeof(ColumnAggregate));
+  }
+  aggregates[col].store = column_store[col];
+  column_store[col] = storeAggregate;
+  releaseColumnValues(col);
+  return true;
+}
+
+bool CSV_Parser::setColumnAggregate(const char * key) { return setColumnAggregate(findColumn(key)); }
+
+CSV_Aggregate CSV_Parser::getAggregate(int col) {
+  if (col < 0 || col >= cols_count || !isAggregated(col))
+    return CSV_Aggregate();
+  return aggregates[col].result;
+}
+
+CSV_Aggregate CSV_Parser::getAggregate(const char * key) { return getAggregate(findColumn(key)); }
+
+bool CSV_Parser::addFilter(int col, CSV_FilterOp op, const char * value) {
+  if (col < 0 || col >= cols_count || !value || rows_count || rows_visited || rows_parsed || current_col)
+    return false;
+  for (int i = 0; i < col; i++)
+    if (isAggregated(i))
+      return false; // values of the aggregated column would be added before the row is rejected
+  
+  double number = 0;
+  if (fmt[col] != 's' && fmt[col] != '-' && !convertNumber(value, value + strlen(value), col, &number))
+    return false;
+  if (!column_filters) {
+    column_filters = (ColumnFilter**)allocMemory(cols_count * sizeof(ColumnFilter*));
+    if (!column_filters)
+      return false;
+    memset(column_filters, 0, cols_count * sizeof(ColumnFilter*));
+  }
+  ColumnFilter * filter = (ColumnFilter*)allocMemory(sizeof(ColumnFilter) + strlen(value) + 1);
+  if (!filter)
+    return false;
+  filter->op = op;
+  filter->number = number;
+  strcpy(filter->value(), value);
+  filter->next = column_filters[col];
+  column_filters[col] = filter;
+  if (col > last_used_col)
+    last_used_col = col; // values of "-" column are parsed to check the filter
+  markRowStrings();
+  return true;
+}
+
+bool CSV_Parser::addFilter(const char * key, CSV_FilterOp op, const char * value) { return addFilter(findColumn(key), op, value); }
+
+uint32_t CSV_Parser::getAcceptedRowsCount() { return rows_accepted; }
+
+uint32_t CSV_Parser::getRejectedRowsCount() { return rows_rejected; }
+
+bool CSV_Parser::setStructArray(void * structs, size_t struct_size_, int capacity) {
+  if (!structs || !struct_size_ || capacity < 1 || struct_array || rows_count || rows_visited || rows_parsed || current_col || row_callback || window_size)
+    return false;
+#ifdef NON_ARDUINO
+  if (mapping || string_views)
+    return false;
+#endif
+  struct_array = (char*)structs;
+  struct_size = struct_size_;
+  struct_capacity = capacity;
+  if (rows_capacity > capacity)
+    rows_capacity = capacity; // values arrays of other columns are grown when the rows don't fit, until the array is full
+  return true;
+}
+
+bool CSV_Parser::setStructArray(size_t struct_size_) {
+  if (!struct_size_ || struct_array || rows_count || rows_visited || rows_parsed || current_col || row_callback || window_size)
+    return false;
+#ifdef NON_ARDUINO
+  if (mapping || string_views)
+    return false;
+#endif
+  // it holds as many rows as values arrays, so it's grown by reserve together with them
+  char * structs = (char*)allocMemory((size_t)rows_capacity * struct_size_);
+  if (!structs)
+    return false;
+  memset(structs, 0, (size_t)rows_capacity * struct_size_);
+  struct_array = structs;
+  struct_size = struct_size_;
+  struct_capacity = rows_capacity;
+  struct_array_owned = true;
+  return true;
+}
+
+void * CSV_Parser::getStructArray() { return struct_array; }
+
+bool CSV_Parser::bindColumn(int col, size_t offset) {
+  if (col < 0 || col >= cols_count || !struct_array || rows_count || current_col)
+    return false;
+  if (fmt[col] == '-' || isAutoColumn(col) || isAggregated(col))
+    return false;
+  int8_t size = isBound(col) ? bound_columns[col].size : valueSize(col);
+  if (offset + size > struct_size)
+    return false;
+  if (!bound_columns) {
+    bound_columns = (BoundColumn*)allocMemory(cols_count * sizeof(BoundColumn));
+    if (!bound_columns)
+      return false;
+    memset(bound_columns, 0, cols_count * sizeof(BoundColumn));
+  }
+  bound_columns[col].offset = offset;
+  if (isBound(col))
+    return true;
+  bound_columns[col].size = size;
+  bound_columns[col].store = column_store[col];
+  column_store[col] = storeBound;
+  releaseColumnValues(col);
+  return true;
+}
+
+bool CSV_Parser::bindColumn(const char * key, size_t offset) { return bindColumn(findColumn(key), offset); }
+
+void CSV_Parser::setSeekCallback(SeekCallback func) {
+  this->seek_callback = func;
+}
+
+/*  Discards csv that wasn't parsed yet (including the incomplete row), so parsing can continue from another position.  */
+void CSV_Parser::resetParsing() {
+  leftover_start = leftover_len = 0;
+  current_col = 0;
+  row_resume = 0;
+  row_dropped = row_rejected = false;
+  skipping_row = skip_in_quotes = skip_in_value = false;
+  ignore_next_delimchar = false;
+  scan_resume = scan_ending_quote = scan_escaped_quotes = 0;
+  markRowStrings();
+}
+
+bool CSV_Parser::addRowOffset(uint32_t offset) {
+  if (row_offsets_count == row_offsets_capacity) {
+    uint32_t capacity = row_offsets_capacity + row_offsets_capacity / 2 + 16;
+    uint32_t * new_offsets = (uint32_t*)reallocMemory(row_offsets, capacity * sizeof(uint32_t));
+    if (!new_offsets) {
+      out_of_memory = true;
+      return false;
+    }
+    row_offsets = new_offsets;
+    row_offsets_capacity = capacity;
+  }
+  row_offsets[row_offsets_count++] = offset;
+  return true;
+}
+
+/*  Blocks of csv are read into leftover (nothing else is parsed meanwhile), each row is skipped the same way as unused 
+    values, which finds its end without parsing its values (quoted new lines are recognized by counting quote chars).  */
+bool CSV_Parser::buildRowIndex(int rows_per_entry) {
+  if (!fillBuffer_callback || !seek_callback || rows_per_entry < 1 || current_col || leftover_start != leftover_len)
+    return false;
+  if (!seek_callback(0) || !reserveLeftover(CSV_PARSER_READ_BLOCK_SIZE))
+    return false;
+  row_offsets_count = 0;
+  row_offsets_step = rows_per_entry;
+  indexed_rows = 0;
+
+  bool in_header = has_header;
+  bool in_row = false;
+  bool success = true;
+  uint32_t offset = 0; // offset of the block within csv
+  size_t n;
+  while (success && (n = fillBuffer_callback(leftover, CSV_PARSER_READ_BLOCK_SIZE)) > 0) {
+    const char * s = leftover;
+    const char * end = leftover + n;
+    while (s < end) {
+      if (!in_row) {
+        // new line chars between rows (e.g. '\n' of "\r\n" split between blocks, or empty lines) don't start a row
+        s += spanNewLines(s, end);
+        if (s == end)
+          break;
+        if (!in_header && indexed_rows % row_offsets_step == 0 && !addRowOffset(offset + (s - leftover))) {
+          success = false;
+          break;
+        }
+        in_row = skipping_row = true;
+      }
+      s = skipRow(s, end);
+      if (!skipping_row) {
+        in_row = false;
+        if (in_header)
+          in_header = false;
+        else
+          indexed_rows++;
+      }
+    }
+    offset += n;
+  }
+  if (in_row && !in_header)
+    indexed_rows++; // the last row doesn't end with a new line
+  skipping_row = skip_in_quotes = skip_in_value = false;
+  return success;
+}
+
+bool CSV_Parser::readRows(uint32_t start, int count) {
+  if (!fillBuffer_callback || !seek_callback || !row_offsets_count || count < 1 || row_callback || window_size)
+    return false;
+  resetParsing();
+  rows_count = 0;
+  freeStrings(true);
+
+  if (!header_parsed) {
+    // header is located before the first indexed row
+    if (!seek_callback(0))
+      return false;
+    for (uint32_t remaining = row_offsets[0]; remaining; ) {
+      size_t block = remaining < CSV_PARSER_READ_BLOCK_SIZE ? remaining : CSV_PARSER_READ_BLOCK_SIZE;
+      if (!reserveLeftover(block))
+        return false;
+      size_t n = fillBuffer_callback(leftover + leftover_len, block);
+      if (!n)
+        break;
+      parseAppendedLeftover(n);
+      remaining -= n;
+    }
+    resetParsing();
+    if (!header_parsed)
+      return false;
+  }
+
+  uint32_t entry = start / row_offsets_step;
+  if (entry >= row_offsets_count)
+    entry = row_offsets_count - 1;
+  if (!seek_callback(row_offsets[entry]))
+    return false;
+  rows_to_skip = start - entry * row_offsets_step;
+  skipping_row = rows_to_skip > 0;
+  rows_limit = count;
+  while (rows_count < count) {
+    if (!reserveLeftover(CSV_PARSER_READ_BLOCK_SIZE))
+      break;
+    size_t n = fillBuffer_callback(leftover + leftover_len, CSV_PARSER_READ_BLOCK_SIZE);
+    if (!n) {
+      parseLeftover();
+      break;
+    }
+    parseAppendedLeftover(n);
+  }
+  rows_limit = 0;
+  rows_to_skip = 0;
+  resetParsing(); // rows following the requested ones are discarded
+  return rows_count > 0;
+}
+
+uint32_t CSV_Parser::getIndexedRowsCount() { return indexed_rows; }
+
+/*  Row index layout: RowIndexHeader followed by "count" offsets (in the byte order of the machine that saved them).  */
+#define CSV_PARSER_ROW_INDEX_VERSION 1
+
+struct RowIndexHeader {
+  char magic[4];        // "CSVI"
+  uint8_t version;
+  uint8_t unused[3];
+  uint32_t step;
+  uint32_t count;
+  uint32_t rows;
+};
+
+bool CSV_Parser::writeRowIndex(SnapshotWrite write, void * ctx) {
+  RowIndexHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, "CSVI", 4);
+  header.version = CSV_PARSER_ROW_INDEX_VERSION;
+  header.step = row_offsets_step;
+  header.count = row_offsets_count;
+  header.rows = indexed_rows;
+  return write(ctx, &header, sizeof(header)) && (!row_offsets_count || write(ctx, row_offsets, row_offsets_count * sizeof(uint32_t)));
+}
+
+bool CSV_Parser::readRowIndex(SnapshotRead read, void * ctx) {
+  RowIndexHeader header;
+  if (!read(ctx, &header, sizeof(header)) || memcmp(header.magic, "CSVI", 4) || header.version != CSV_PARSER_ROW_INDEX_VERSION || !header.step)
+    return false;
+  if (header.count > (size_t)-1 / sizeof(uint32_t))
+    return false; // size of a damaged count would wrap around (on 16 and 32-bit targets)
+  size_t offsets_size = (size_t)header.count * sizeof(uint32_t);
+  row_offsets_count = 0;
+  if (header.count > row_offsets_capacity) {
+    freeMemory(row_offsets);
+    row_offsets_capacity = 0;
+    row_offsets = (uint32_t*)allocMemory(offsets_size);
+    if (!row_offsets) {
+      out_of_memory = true;
+      return false;
+    }
+    row_offsets_capacity = header.count;
+  }
+  if (!read(ctx, row_offsets, offsets_size))
+    return false;
+  row_offsets_count = header.count;
+  row_offsets_step = header.step;
+  indexed_rows = header.rows;
+  return true;
+}
+
+bool CSV_Parser::saveRowIndex(Stream & out) { return writeRowIndex(writeToStream, &out); }
+bool CSV_Parser::loadRowIndex(Stream & in) { return readRowIndex(readFromStream, &in); }
+
+#ifdef NON_ARDUINO
+static bool readFromFile(void * file, void * data, size_t len) {
+  return fread(data, 1, len, (FILE*)file) == len;
+}
+
+bool CSV_Parser::saveRowIndex(const char * f_name) {
+  FILE * file = fopen(f_name, "wb");
+  if (!file)
+    return false;
+  bool success = writeRowIndex(writeToFile, file);
+  return fclose(file) == 0 && success;
+}
+
+bool CSV_Parser::loadRowIndex(const char * f_name) {
+  FILE * file = fopen(f_name, "rb");
+  if (!file)
+    return false;
+  bool success = readRowIndex(readFromFile, file);
+  fclose(file);
+  return success;
+}
+
+bool CSV_Parser::readFileParallel(const char *f_name, int threads) {
+  int fd = open(f_name, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  char * content = fstat(fd, &st) == 0 ? (char*)malloc(st.st_size + 1) : 0;
+  size_t len = 0;
+  while (content && len < (size_t)st.st_size) {
+    ssize_t n = read(fd, content + len, st.st_size - len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      break;
+    len += n;
+  }
+  close(fd);
+  if (!content)
+    return false;
+  content[len] = 0;
+  bool success = len == (size_t)st.st_size && parseParallel(content, threads);
+  free(content); // strings are copied, so the content isn't needed after parsing
+  return success;
+}
+
+bool CSV_Parser::mapFile(const char * f_name) {
+  if (mapping || window_size || struct_array || rows_count || current_col || leftover_len)
+    return false;
+  if (!row_callback) {
+    // row callback gets views of strings anyway (relative to the row, but the mapped row never moves)
+    for (int col = 0; col < cols_count; col++) {
+      if (fmt[col] != 's')
+        continue;
+      void * new_values = reallocMemory(values[col], rows_capacity * sizeof(CSV_String));
+      if (!new_values)
+        return false;
+      values[col] = new_values;
+    }
+  }
+
+  int fd = open(f_name, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  // The file is mapped at the beginning of an anonymous (zero filled) mapping larger by at least 1 byte, so the csv is 
+  // terminated by 0 like any other supplied string (mapping just "len + 1" bytes isn't enough when "len" is a multiple 
+  // of the page size, because reading past the end of the file would cause SIGBUS).
+  size_t len = st.st_size;
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t size = (len / page_size + 1) * page_size;
+  void * area = mmap(0, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (area != MAP_FAILED && len && mmap(area, len, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+    munmap(area, size);
+    area = MAP_FAILED;
+  }
+  close(fd);
+  if (area == MAP_FAILED)
+    return false;
+  madvise(area, len, MADV_SEQUENTIAL);
+  mapping = (char*)area;
+  mapping_size = size;
+
+  if (!row_callback) {
+    string_views = true;
+    for (int col = 0; col < cols_count; col++)
+      if (fmt[col] == 's')
+        column_store[col] = storeMappedString;
+  }
+
+  // parsed the same way as csv supplied with the constructor, but the last value is parsed without copying it to leftover
+  whole_csv_supplied = false;
+  const char * end = mapping + len;
+  const char * rest = parseChunk(skipIgnoredDelimChar(mapping, end), end);
+  if (rest != end || current_col)
+    parseLastValue(rest, end);
+  return true;
+}
+
+/*  parseParallel splits csv into chunks, the first one is parsed by this parser (including header), 
+    the others by separate parsers (without header) running in their own threads.  
+    A chunk parsed independently is correct only if it starts where a row starts. It's checked after parsing: 
+    if the previous chunk didn't end exactly at the end of a row (e.g. because the split landed inside a quoted value, 
+    or because rows had fewer values than columns), the chunk is parsed again by the parser of the previous chunk 
+    (continuing from where it stopped), so the result is always the same as with sequential parsing.  */
+bool CSV_Parser::parseParallel(const char * s, int threads) {
+  if (pool || row_callback || window_size || aggregates || column_filters || struct_array || rows_count || current_col || leftover_len)
+    return false;
+  const char * end = s + strlen(s);
+  if (threads <= 0)
+    threads = std::thread::hardware_concurrency();
+  size_t max_chunks = (end - s) / CSV_PARSER_PARALLEL_MIN_CHUNK_SIZE + 1;
+  if (threads < 1)
+    threads = 1;
+  if ((size_t)threads > max_chunks)
+    threads = max_chunks;
+
+  std::vector<const char*> bounds(threads + 1);
+  int chunks = splitChunks(s, end, threads, &bounds[0]);
+
+  std::string format;
+  for (int col = 0; col < cols_count; col++) {
+    if (isAutoColumn(col)) {
+      format += 'a';
+      continue;
+    }
+    if (is_fmt_unsigned[col])
+      format += 'u';
+    format += fmt[col];
+    if (fmt[col] == 'q')
+      format += '0' + fixed_scales[col];
+  }
+  std::vector<CSV_Parser*> parsers(chunks, this);
+  std::vector<const char*> rests(chunks);
+  std::vector<std::thread> workers;
+  for (int i = 1; i < chunks; i++) {
+    parsers[i] = new CSV_Parser(format.c_str(), false, delimiter, quote_char);
+    workers.push_back(std::thread([&parsers, &rests, &bounds, i]() { 
+      rests[i] = parsers[i]->parseChunk(bounds[i], bounds[i + 1]); 
+    }));
+  }
+  rests[0] = parseChunk(bounds[0], bounds[1]);
+  for (size_t i = 0; i < workers.size(); i++)
+    workers[i].join();
+
+  // "last" is the chunk whose parser continues (with the next chunk) if the next chunk can't be used
+  std::vector<CSV_Parser*> used(1, this);
+  int last = 0;
+  for (int i = 1; i < chunks; i++) {
+    CSV_Parser * cp = parsers[last];
+    if (rests[last] == bounds[i] && cp->current_col == 0 && !cp->skipping_row && cp->header_parsed) {
+      used.push_back(parsers[i]);
+      last = i;
+    } else {
+      rests[last] = cp->parseChunk(rests[last], bounds[i + 1]);
+    }
+  }
+  parsers[last]->finishChunks(rests[last], end);
+
+  int total_rows = 0;
+  for (size_t i = 0; i < used.size(); i++)
+    total_rows += used[i]->rows_count;
+  bool success = reserve(total_rows);
+  if (!success)
+    out_of_memory = true;
+  for (size_t i = 1; i < used.size() && success; i++)
+    success = appendRows(*used[i]);
+  for (int i = 1; i < chunks; i++)
+    delete parsers[i];
+  return success;
+}
+
+/*  Returns the number of "c" chars between s and end.  */
+static size_t countChar(const char * s, const char * end, char c) {
+  size_t count = 0;
+#if defined(CSV_PARSER_SIMD)
+  uint64_t delim_mask, quote_mask;
+  for (; end - s >= 64; s += 64) {
+    scanBlock(s, c, c, &delim_mask, &quote_mask);
+    count += __builtin_popcountll(quote_mask);
+  }
+#endif
+  for (; s < end; s++)
+    count += *s == c;
+  return count;
+}
+
+/*  Splits csv into at most "chunks" chunks starting at beginnings of rows, returns the number of chunks
+    (bounds[i] is the beginning of the i-th chunk, bounds[chunks] == end).  
+    Splits are placed after new lines following equally distant positions. A new line preceded by an odd number 
+    of quote chars is a part of a quoted value (in well formed csv), so quote chars of each chunk are counted 
+    (in parallel) and such split is moved to the end of the row.  */
+int CSV_Parser::splitChunks(const char * s, const char * end, int chunks, const char ** bounds) {
+  size_t len = end - s;
+  int count = 1;
+  bounds[0] = s;
+  for (int i = 1; i < chunks; i++) {
+    const char * p = s + len / chunks * i;
+    if (p < bounds[count - 1])
+      p = bounds[count - 1];
+    p = (const char*)memchr(p, '\n', end - p);
+    if (!p)
+      break;
+    p += spanNewLines(p, end);
+    if (p == end)
+      break;
+    bounds[count++] = p;
+  }
+  bounds[count] = end;
+  if (count == 1)
+    return 1;
+
+  std::vector<size_t> quotes(count, 0);
+  std::vector<std::thread> counters;
+  for (int i = 0; i < count; i++) {
+    counters.push_back(std::thread([&quotes, bounds, i](char quote_char) {
+      quotes[i] = countChar(bounds[i], bounds[i + 1], quote_char);
+    }, quote_char));
+  }
+  for (size_t i = 0; i < counters.size(); i++)
+    counters[i].join();
+
+  // bounds are moved in place (the number of kept ones never exceeds the number of processed ones)
+  bool odd = false;
+  int kept = 1;
+  for (int i = 1; i < count; i++) {
+    odd = odd != (quotes[i - 1] & 1);
+    const char * p = bounds[i];
+    const char * next = bounds[i + 1];
+    if (odd) {
+      // the rest of the quoted value and of the row is skipped in the same way as unused values of a row
+      skipping_row = skip_in_quotes = true;
+      p = skipRow(p, next);
+      if (skipping_row)
+        p = next; // the chunk is joined with the previous one
+      skipping_row = skip_in_quotes = skip_in_value = false;
+    }
+    if (p < next)
+      bounds[kept++] = p;
+  }
+  bounds[kept] = end;
+  return kept;
+}
+
+/*  Parses the rest of the last chunk, the last value doesn't have to end with a new line (like with parseLeftover).  */
+void CSV_Parser::finishChunks(const char * rest, const char * end) {
+  size_t len = end - rest;
+  if (len && reserveLeftover(len)) {
+    memcpy(leftover, rest, len);
+    leftover_len = len;
+    leftover[len] = 0;
+  }
+  parseLeftover();
+}
+
+/*  Appends rows of another parser (with the same format) to already reserved values arrays. 
+    Strings aren't copied, slabs holding them are taken over instead. 
+    Auto integer columns of both parsers are widened to the type holding values of both of them first.  */
+bool CSV_Parser::appendRows(CSV_Parser & other) {
+  for (int col = 0; col < cols_count; col++) {
+    if (!isAutoColumn(col))
+      continue;
+    AutoColumn & range = auto_columns[col];
+    const AutoColumn & other_range = other.auto_columns[col];
+    if (other_range.max_positive > range.max_positive)
+      range.max_positive = other_range.max_positive;
+    if (other_range.max_negative > range.max_negative)
+      range.max_negative = other_range.max_negative;
+    if (!fitAutoColumn(col))
+      return false;
+    if ((other.fmt[col] != fmt[col] || other.is_fmt_unsigned[col] != is_fmt_unsigned[col]) && 
+        !other.widenColumn(col, fmt[col], is_fmt_unsigned[col])) {
+      out_of_memory = true;
+      return false;
+    }
+  }
+  for (int col = 0; col < cols_count; col++) {
+    int8_t type_size = valueSize(col);
+    if (type_size)
+      memcpy((char*)values[col] + (size_t)rows_count * type_size, other.values[col], (size_t)other.rows_count * type_size);
+  }
+  rows_count += other.rows_count;
+  rows_accepted += other.rows_accepted;
+  conversion_errors += other.conversion_errors;
+  out_of_memory = out_of_memory || other.out_of_memory;
+#ifdef CSV_PARSER_ENABLE_STATS
+  // times of parsers running at the same time are summed (like CPU time)
+  stats.bytes_parsed += other.stats.bytes_parsed;
+  stats.rows_parsed += other.stats.rows_parsed;
+  stats.values_parsed += other.stats.values_parsed;
+  stats.allocs += other.stats.allocs;
+  stats.reallocs += other.stats.reallocs;
+  stats.frees += other.stats.frees;
+  stats.allocated_bytes += other.stats.allocated_bytes;
+  parse_time += other.parse_time;
+  convert_time += other.convert_time;
+  store_time += other.store_time;
+  callback_time += other.callback_time;
+#endif
+
+  if (other.string_slabs) {
+    StringSlab * other_last = other.string_slabs;
+#ifdef CSV_PARSER_ENABLE_STATS
+    // memory of the taken over slabs is counted by this parser from now on
+    for (StringSlab * slab = other.string_slabs; slab; slab = slab->next) {
+      addMemoryUsed(sizeof(StringSlab) + slab->capacity);
+      other.stats.memory_used -= sizeof(StringSlab) + slab->capacity;
+    }
+#endif
+    while (other_last->next)
+      other_last = other_last->next;
+    // they're placed behind the current slab, so it's still filled first
+    if (string_slabs) {
+      other_last->next = string_slabs->next;
+      string_slabs->next = other.string_slabs;
+    } else {
+      string_slabs = other.string_slabs;
+    }
+    other.string_slabs = 0;
+  }
+  return true;
+}
+#endif
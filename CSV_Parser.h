@@ -30,10 +30,126 @@
     extern SerialClass Serial;
 #endif
 
+/*  Size of blocks in which readSDfile (and readFile/readFd in non-Arduino builds) reads the file.
+    Leftover buffer grows to at least that size while the file is read, it is released afterwards.  */
+#ifndef CSV_PARSER_READ_BLOCK_SIZE
+  #if defined(NON_ARDUINO)
+    #define CSV_PARSER_READ_BLOCK_SIZE 65536
+  #elif defined(__AVR__)
+    #define CSV_PARSER_READ_BLOCK_SIZE 64
+  #else
+    #define CSV_PARSER_READ_BLOCK_SIZE 512
+  #endif
+#endif
+
+/*  Size of slabs in which strings (values of "s" columns) are stored.  */
+#ifndef CSV_PARSER_STRING_SLAB_SIZE
+  #if defined(NON_ARDUINO)
+    #define CSV_PARSER_STRING_SLAB_SIZE 4096
+  #elif defined(__AVR__)
+    #define CSV_PARSER_STRING_SLAB_SIZE 64
+  #else
+    #define CSV_PARSER_STRING_SLAB_SIZE 256
+  #endif
+#endif
+
+/*  Minimum size of chunks parsed by separate threads (see parseParallel), smaller inputs use fewer threads.  */
+#ifndef CSV_PARSER_PARALLEL_MIN_CHUNK_SIZE
+  #define CSV_PARSER_PARALLEL_MIN_CHUNK_SIZE (1 << 20)
+#endif
+
+/*  Alignment of blocks carved from the memory pool (see the constructor accepting a pool).  */
+#ifndef CSV_PARSER_POOL_ALIGNMENT
+  #define CSV_PARSER_POOL_ALIGNMENT (sizeof(void*) > sizeof(float) ? sizeof(void*) : sizeof(float))
+#endif
+
+/*  CSV_Parser::getStats is available only when CSV_PARSER_ENABLE_STATS is defined (for the whole build, because it changes 
+    the size of CSV_Parser objects, e.g. with "-DCSV_PARSER_ENABLE_STATS" build flag). Otherwise nothing is counted or timed.  */
+
+/*  Non-Arduino builds find ends of values with SIMD instructions (SSE2/AVX2 on x86, NEON on 64-bit ARM).
+    It can be disabled by defining CSV_PARSER_NO_SIMD.  */
+#if defined(NON_ARDUINO) && !defined(CSV_PARSER_NO_SIMD) && defined(__GNUC__) && \
+    (defined(__SSE2__) || defined(__AVX2__) || (defined(__ARM_NEON) && defined(__aarch64__)))
+  #define CSV_PARSER_SIMD
+#endif
+
 typedef char (*FeedRowParserCallback)();
 typedef char* (*FeedRowParserStrCallback)();
 typedef bool (*RowParserFinishedCallback)();
+typedef size_t (*FillBufferCallback)(char * buf, size_t capacity);
+typedef bool (*SeekCallback)(uint32_t position);
+
+/** @brief Handle of a column returned by CSV_Parser::getColumn. Resolving the column name once (instead of using cp["my_key"] 
+    in a loop) avoids repeated lookups, the handle also tells the type of values.  */
+struct CSV_Column {
+  int index;        // column index (-1 if the column wasn't found)
+  char type;        // format specifier of the column ('s', 'f', 'L', 'd', 'c', 'x', 'q' or '-'), without "u" (current type of "a" columns)
+  bool is_unsigned; // whether "u" preceded the format specifier (or "a" column holds unsigned values)
+  uint8_t scale;    // number of decimal places of "q" column (its values are stored multiplied by 10^scale), 0 for other columns
+
+  bool found() const { return index >= 0; }
+};
+
+/** @brief String value passed to the row callback (see CSV_Parser::setRowCallback) or stored by CSV_Parser::mapFile. 
+    It points into the parsed csv (or into memory of the parser if the value contained escaped quote chars), so it's not terminated by 0.  */
+struct CSV_String {
+  const char * s;
+  int len;
+};
+
+#ifdef CSV_PARSER_ENABLE_STATS
+/** @brief Statistics returned by CSV_Parser::getStats (available only when CSV_PARSER_ENABLE_STATS is defined). 
+    Times are cumulative, measured with micros() on Arduino and steady clock in non-Arduino builds.  */
+struct CSV_Stats {
+  uint32_t bytes_parsed;      // chars of csv processed by the parser (including header, unused values and skipped rows)
+  uint32_t rows_parsed;       // complete rows (excluding header), including rows passed to the row callback or dropped
+  uint32_t values_parsed;     // values found in csv (excluding unused values skipped at the ends of rows)
+  uint32_t allocs;            // number of memory allocations (including the ones that failed)
+  uint32_t reallocs;
+  uint32_t frees;
+  uint32_t allocated_bytes;   // total number of bytes requested by allocations and reallocations
+  size_t memory_used;         // bytes currently allocated by the parser (from the heap or the pool)
+  size_t memory_peak;         // maximum of memory_used
+  uint32_t conversion_errors; // the same as CSV_Parser::getConversionErrorsCount
+  uint32_t tokenize_us;       // time spent finding values (excluding the times below)
+  uint32_t convert_us;        // time spent converting numbers
+  uint32_t store_us;          // time spent storing strings and growing values arrays
+  uint32_t callback_us;       // time spent in the row callback (see CSV_Parser::setRowCallback)
+};
+#endif
 
+/** @brief Running statistics of a column returned by CSV_Parser::getAggregate (see CSV_Parser::setColumnAggregate). 
+    Empty values aren't included.  */
+struct CSV_Aggregate {
+  uint32_t count; // number of values
+  double min;
+  double max;
+  double sum;
+  double mean;
+  double m2;      // sum of squared differences from the mean (Welford's algorithm), see variance()
+
+  /** @brief Sample variance of the values (0 if there are less than 2 values).  */
+  double variance() const { return count > 1 ? m2 / (count - 1) : 0; }
+};
+
+/** @brief Comparison used by CSV_Parser::addFilter.  */
+enum CSV_FilterOp {
+  CSV_EQUAL,
+  CSV_NOT_EQUAL,
+  CSV_LESS,
+  CSV_LESS_OR_EQUAL,
+  CSV_GREATER,
+  CSV_GREATER_OR_EQUAL
+};
+
+class CSV_Row;
+typedef void (*CSV_RowCallback)(CSV_Row & row, void * user_data);
+
+/** @brief Parses csv into arrays of values (one array per column). All parsing state is kept in the object, so separate 
+    CSV_Parser objects (including CSV_ParserT objects, their format string is a compile-time constant) can be used by separate 
+    threads (or ESP32 tasks) at the same time without locking. A single object must not be used by multiple threads at once 
+    (except parseParallel, which manages its own threads). The only shared defaults are the global feedRowParser and 
+    rowParserFinished functions used by parseRow (see setFeedRowParserCallback and setFillBufferCallback).  */
 class CSV_Parser {
   char ** keys;
   void ** values;
@@ -50,9 +166,15 @@ class CSV_Parser {
      When supplied format is "udud", then:
          fmt = "dd"
          is_fmt_unsigned = {true, true}
+
+     When supplied format is "a" (auto integer), then it starts as:
+         fmt = "c"
+         is_fmt_unsigned = {true}
+     and both are changed when the column is widened (see AutoColumn below).
   */
  
   int rows_count, cols_count;
+  int rows_capacity; // number of rows that each of the values arrays can hold before it must be reallocated
 
   bool has_header;
   char delimiter;
@@ -66,9 +188,129 @@ class CSV_Parser {
                            // this member will allow to check it throughout the class
 
   /*  Members responsible for keeping track of chunked supply of csv string.  */
-  char * leftover;        // string that wasn't parsed yet because it doesn't end with delimiter or new line
+  char * leftover;          // buffer holding the part of csv that wasn't parsed yet because it doesn't end with delimiter or new line
+  size_t leftover_start;    // read cursor, index of the first unparsed char within leftover
+  size_t leftover_len;      // index of the terminating 0 of leftover (unparsed chars are between leftover_start and leftover_len)
+  size_t leftover_capacity; // number of bytes allocated for leftover, it grows geometrically to keep appending cheap
   int current_col;
   bool header_parsed;
+  bool ignore_next_delimchar; // set when the parsed chunk ended with new line chars, so '\n' (after '\r') or empty lines
+                              // at the beginning of the next chunk are skipped
+
+  /*  When all remaining columns of the row are unused ("-"), the rest of the row is skipped without parsing its values.  */
+  int last_used_col;   // index of the last column that isn't "-" (-1 if there's none)
+  bool skipping_row;   // set while looking for the end of the row (it may span multiple chunks)
+  bool skip_in_quotes; // set when an odd number of quote chars was skipped (so new line chars are part of a value)
+  bool skip_in_value;  // set when the last skipped char isn't the end of a value (so a quote char doesn't start a quoted value)
+
+  /*  Append-only arena holding strings of "s" columns (values arrays store pointers into it).  */
+  struct StringSlab {
+    StringSlab * next;
+    size_t used, capacity;
+    char * data() { return (char*)(this + 1); }
+  };
+  StringSlab * string_slabs; // the most recent slab (the one being filled), older ones are linked by "next"
+
+  /*  Progress of parseStringValue within an incomplete value (offsets are relative to the start of the value, 
+      so they stay valid when the value is moved to/within leftover).  */
+  int scan_resume;         // where the scanning continues (0 = start of the value)
+  int scan_ending_quote;   // ending quote of a quoted value, found before any delimiter followed it (0 = not found yet)
+  int scan_escaped_quotes; // number of 2 adjacent quote chars found so far
+
+#if defined(CSV_PARSER_SIMD)
+  /*  Bitmasks of structural chars of the most recently scanned 64-byte block (see findStructuralChar).  */
+  const char * scan_block;
+  uint64_t scan_delim_mask;
+  uint64_t scan_quote_mask;
+  const char * findStructuralChar(const char * s, const char * end, bool quote);
+#endif
+
+  /*  Value found by parseStringValue. It points into the parsed chunk (it's not terminated by 0).  */
+  struct ParsedValue {
+    const char * s; // first char of the value (opening quote char is not included)
+    int len;        // length of the value after turning 2's of adjacent quote chars into 1's
+    bool quoted;    // whether the value was enclosed in quote chars
+  };
+
+  /*  Functions storing values of specific types (e.g. storeInteger<int16_t, 10> for "d"), one is assigned to each 
+      column by the constructor (0 for unused columns), so the type isn't checked again for every parsed value.  */
+  typedef void (*ColumnStore)(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+  ColumnStore * column_store;
+  static ColumnStore getColumnStore(char type_specifier, bool is_unsigned);
+  static void storeString(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+  static void storeFloat(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+  template<typename T, uint8_t base> static void storeInteger(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+  template<typename T> static void storeFixed(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+
+  /*  Constructor used by CSV_ParserT, store functions of columns are given by "stores" (selected at compile time from 
+      the column types) instead of getColumnStore, which refers to store functions of all types.  */
+  CSV_Parser(void * pool, size_t pool_size, const char * fmt, const ColumnStore * stores, bool has_header, char delimiter, char quote_char);
+  template<typename... T> friend class CSV_ParserT;
+  uint8_t * fixed_scales; // number of decimal places of each column ("q" columns only, 0 if the format has no "q" column)
+
+  /*  Auto integer columns ("a") start as uint8_t and they're widened when a value doesn't fit. The largest magnitudes of 
+      positive and negative values seen so far decide the narrowest type that holds all values of the column.  */
+  struct AutoColumn {
+    bool used;
+    uint32_t max_positive;
+    uint32_t max_negative;
+  };
+  AutoColumn * auto_columns; // 0 if the format has no "a" columns
+  bool isAutoColumn(int col) const { return auto_columns && auto_columns[col].used; }
+  static void storeAutoInteger(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+  bool fitAutoColumn(int col);
+  bool widenColumn(int col, char type_specifier, bool is_unsigned);
+
+  /*  Aggregated and bound columns keep only a single value in their values array, the original store function of the 
+      column converts each value into it, then it's added to the statistics or copied into the struct of the row.  */
+  void releaseColumnValues(int col);
+
+  /*  Columns set by setColumnAggregate, their values are only added to the running statistics (see releaseColumnValues).  */
+  struct ColumnAggregate {
+    ColumnStore store; // 0 if the column isn't aggregated
+    CSV_Aggregate result;
+  };
+  ColumnAggregate * aggregates; // 0 if setColumnAggregate wasn't called
+  bool isAggregated(int col) const { return aggregates && aggregates[col].store; }
+  static void storeAggregate(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+
+  /*  Filters added by addFilter. They're checked before the value is stored, a row with a value that doesn't match 
+      is rejected: strings already stored for it are released and its remaining values are skipped (like unused values).  */
+  struct ColumnFilter {
+    CSV_FilterOp op;
+    double number;      // value of the filter converted according to the column type (numeric columns only)
+    ColumnFilter * next; // another filter of the same column
+    char * value() { return (char*)(this + 1); } // value of the filter as supplied, it's stored right after the struct
+  };
+  ColumnFilter ** column_filters; // filters of each column (0 if addFilter wasn't called)
+  bool row_rejected;              // set when a value of the row currently being parsed didn't match a filter
+  uint32_t rows_accepted, rows_rejected;
+  bool acceptValue(const ParsedValue & val, int col);
+  bool matchesFilter(ColumnFilter & filter, const ParsedValue & val, int col);
+  bool convertNumber(const char * s, const char * end, int col, double * number);
+  int compareValue(const ParsedValue & val, const char * s);
+  void rejectRow();
+
+  /*  Position of the strings arena when the current row started, strings allocated since then are released when the row 
+      is rejected (slabs in front of row_slab and between it and row_slab_next were allocated for the row).  */
+  StringSlab * row_slab;
+  StringSlab * row_slab_next;
+  size_t row_slab_used;
+  void markRowStrings();
+
+  /*  Array of structs set by setStructArray, values of bound columns are stored in fields of the structs (see releaseColumnValues).  */
+  char * struct_array;
+  size_t struct_size;
+  int struct_capacity;    // number of structs the array can hold
+  bool struct_array_owned; // whether the array was allocated by the parser (it grows together with values arrays)
+  struct BoundColumn {
+    ColumnStore store; // 0 if the column isn't bound
+    size_t offset;     // offset of the field within the struct
+    int8_t size;       // size of the field (the same as the size of the value)
+  };
+  BoundColumn * bound_columns; // 0 if bindColumn wasn't called
+  bool isBound(int col) const { return bound_columns && bound_columns[col].store; }
+  static void storeBound(CSV_Parser & cp, const ParsedValue & val, int row, int col);
 
   // std::function<char()> feedRowParser_callback;
   // std::function<char*()> feedRowParserStr_callback;
@@ -77,20 +319,143 @@ class CSV_Parser {
   FeedRowParserCallback feedRowParser_callback;
   FeedRowParserStrCallback feedRowParserStr_callback;
   RowParserFinishedCallback rowParserFinished_callback;
+  FillBufferCallback fillBuffer_callback;
+  int rows_limit; // parseChunk stops (leaving the rest of csv in leftover) once rows_count reaches it (0 = no limit)
+
+  /*  Row visitor (see setRowCallback), values of each row are passed to the callback and they're overwritten by the next row.  */
+  CSV_RowCallback row_callback;
+  void * row_callback_data;
+  int rows_visited;
+  const char * row_start; // first char of the row being parsed, strings of the row are located relative to it 
+                          // (the incomplete row is kept in leftover, so strings of its parsed values stay available)
+  int row_resume;         // where parsing of the incomplete row continues (relative to row_start)
+  int * string_offsets;   // offsets of strings of the row relative to row_start (-1 if the string was copied)
+  static void storeStringView(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+  void visitRow();
+
+  /*  Row window (see setRowWindow), values arrays are used as circular buffers holding the last "window_size" rows 
+      and the row being parsed (in the slot following the newest row).  */
+  int window_size;         // 0 = all rows are stored
+  int window_next;         // position (within values arrays) of the row being parsed
+  uint32_t rows_parsed;    // number of all rows parsed in window mode (including the dropped ones)
+  char * window_strings;   // fixed size slots for strings of "s" columns (values of these columns point to them)
+  int window_string_len;   // longer strings are truncated
+  static void storeWindowString(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+  int newRowPosition() const { return window_size ? window_next : rows_count; }
+
+  /*  Snapshot and row index (see saveSnapshot and saveRowIndex) are written and read through these functions, 
+      so the same code handles streams and files.  */
+  typedef bool (*SnapshotWrite)(void * ctx, const void * data, size_t len);
+  typedef bool (*SnapshotRead)(void * ctx, void * data, size_t len);
+
+  /*  Row index (see buildRowIndex), byte offsets of every "row_offsets_step"-th row (relative to the beginning of csv).  */
+  uint32_t * row_offsets;
+  uint32_t row_offsets_count;
+  uint32_t row_offsets_capacity;
+  uint32_t row_offsets_step;
+  uint32_t indexed_rows;   // number of rows found by buildRowIndex
+  uint32_t rows_to_skip;   // rows skipped by readRows (like unused values, without parsing them)
+  SeekCallback seek_callback;
+  bool addRowOffset(uint32_t offset);
+  bool writeRowIndex(SnapshotWrite write, void * ctx);
+  bool readRowIndex(SnapshotRead read, void * ctx);
+  void resetParsing();
+
+#ifdef NON_ARDUINO
+  /*  File mapped by mapFile, it's unmapped by the destructor because values of "s" columns point into it.  */
+  char * mapping;
+  size_t mapping_size;
+  bool string_views; // values of "s" columns are CSV_String instead of char*
+  static void storeMappedString(CSV_Parser & cp, const ParsedValue & val, int row, int col);
+#endif
+  int8_t valueSize(int col) const; // size of a single value of the column (0 for unused columns)
+  CSV_String getStoredString(int col, int row) const; // value of "s" column (whether it's stored as char* or CSV_String)
+
+  /*  Memory pool supplied by the user (if it's 0 then the heap is used).  */
+  char * pool;
+  size_t pool_size;
+  size_t pool_used;
+  size_t pool_high_water_mark;
+  bool out_of_memory; // set when any allocation failed (values that didn't fit in memory are not stored)
+  bool row_dropped;   // set when values of the row currently being parsed couldn't be stored, such row isn't counted
+  int conversion_errors; // number of numeric values that were invalid or out of range of their type
+
+#ifdef CSV_PARSER_ENABLE_STATS
+  /*  Counters returned by getStats. Heap blocks are preceded by their size (like blocks of the pool), so freed memory 
+      can be subtracted from memory_used. Times are accumulated in units of statsTime and converted by getStats.  */
+#ifdef NON_ARDUINO
+  typedef uint64_t StatsTime; // nanoseconds
+#else
+  typedef uint32_t StatsTime; // microseconds
+#endif
+  CSV_Stats stats;
+  StatsTime parse_time, convert_time, store_time, callback_time;
+  static StatsTime statsTime();
+  void addMemoryUsed(size_t size);
+#endif
+
+  /*  Hash table (open addressing, linear probing) of column indexes + 1 (0 = empty slot), indexed by FNV-1a hash of keys.
+      It's built when the header is parsed, until then (or if it couldn't be allocated) keys are searched linearly.  */
+  int16_t * key_index;
+  int key_index_size; // power of 2
+  void buildKeyIndex();
+  int findColumn(const char * key);
+
+  void * allocMemory(size_t size);
+  void * reallocMemory(void * ptr, size_t size);
+  void freeMemory(void * ptr);
+  size_t poolAvailable();
 
   /*  Private methods  */
-  char * parseStringValue(const char *, int * chars_occupied);
-  void saveNewValue(const char * val, char type_specifier, int row, int col, bool is_unsigned);
+  bool parseStringValue(const char * s, const char * end, int * chars_occupied, ParsedValue * val);
+  const char * findDelimChar(const char * s, const char * end);
+  const char * findQuoteChar(const char * s, const char * end);
+  void copyValue(char * dst, const ParsedValue & val);
+  void saveNewValue(const ParsedValue & val, int row, int col);
+  bool ensureRowsCapacity();
   
   static int8_t getTypeSize(char type_specifier);
   static const char * getTypeName(char type_specifier, bool is_unsigned); 
 
   void AssignIsFmtUnsignedArray(const char * fmt_);
 
-  /*  Helper functions useful for handling unsigned format specifiers.  */
-  static char * strdup_ignoring_u(const char *s);
+  /*  Helper functions useful for handling unsigned format specifiers (and scale digits of "q" specifiers).  */
+  char * strdup_ignoring_u(const char *s);
   static size_t strlen_ignoring_u(const char *s);
-  static char * strdup_trimmed(const char * s);
+  char * strdup_trimmed(const ParsedValue & val);
+
+  char * allocString(size_t len);
+  void freeStrings(bool keep_slab);
+
+  /*  Makes sure that "extra_len" more chars (and terminating 0) can be appended to leftover.
+      Already parsed chars are discarded (by moving unparsed ones to the beginning) only if that frees at least half of the buffer,
+      otherwise the buffer is grown geometrically. That way supplying N bytes costs O(N) regardless of chunk size.  */
+  bool reserveLeftover(size_t extra_len);
+
+  /*  Parses values from s (until incomplete value or end is reached), returns pointer to the first unparsed char.  
+      Chunk must be terminated by 0 at "end".  */
+  const char * parseChunk(const char *s, const char *end);
+  const char * skipIgnoredDelimChar(const char *s, const char *end);
+  const char * skipRow(const char *s, const char *end);
+  void endRow();
+
+  uint32_t formatHash();
+  bool writeSnapshot(SnapshotWrite write, void * ctx);
+  bool readSnapshot(SnapshotRead read, void * ctx);
+  bool readSnapshotData(SnapshotRead read, void * ctx, int rows);
+
+  /*  Parses the last value of csv, which doesn't have to end with a new line (used by parseLeftover and mapFile).  */
+  void parseLastValue(const char * s, const char * end);
+
+  /*  Parses "appended_len" chars that were written directly at the end of leftover (e.g. by reading a file block into it).  */
+  void parseAppendedLeftover(size_t appended_len);
+
+#ifdef NON_ARDUINO
+  /*  Used by parseParallel.  */
+  int splitChunks(const char * s, const char * end, int chunks, const char ** bounds);
+  void finishChunks(const char * rest, const char * end);
+  bool appendRows(CSV_Parser & other);
+#endif
 
   /*  Passes part of csv string to be parsed.  
       Passing the string by chunks will allow the program using CSV_Parser to occupy much less memory (because it won't have to store the whole string). 
@@ -114,7 +479,7 @@ public:
 	@param delimiter (optional) - It's a character that separates values. By default it's a comma. If the delimiter is not a comma (e.g. if it's ";" or "\t" instead) then it may be supplied.  
 	@param quote_char (optional) - Quote char allows to include delimiter or new line characters to be part of the string value itself. By default it's double quote character.    
   */
-  CSV_Parser(const char * s, const char * fmt, bool has_header=true, char delimiter=',', char quote_char='"');
+  CSV_Parser(const char * s, const char * fmt, bool has_header=true, char delimiter=',', char quote_char='"') : CSV_Parser((void*)0, 0, s, fmt, has_header, delimiter, quote_char) {}
 
   /** @brief Additional constructor to allow supplying quote char as a string. Why?   
 	  Because supplied quote char is likely to be a single-quote, which would require escaping using backslash if it was supplied as char.
@@ -125,6 +490,17 @@ public:
   CSV_Parser(const char * fmt_, bool hh=true, char d=',', char qc='"') : CSV_Parser(0, fmt_, hh, d, qc) {}
   CSV_Parser(const char * fmt_, bool hh, char d, const char * qc)      : CSV_Parser(0, fmt_, hh, d, qc[0]) {}
 
+  /** @brief Constructor for parsing without using the heap at all. All memory of the parser (including values, keys, strings 
+      and the not yet parsed chunks) is carved from the supplied buffer (e.g. a static array), so memory usage is known at compile time.  
+      When the pool is exhausted, rows that don't fit are not stored and outOfMemory() starts returning true.  
+      Calling reserve(rows) before parsing is recommended, because (apart from the most recently allocated block) memory 
+      given back to the pool isn't reused.  
+      @param pool - buffer owned by the caller, it must outlive the CSV_Parser object  
+      @param pool_size - size of the buffer in bytes  
+      Remaining parameters are the same as in the other constructors.  */
+  CSV_Parser(void * pool, size_t pool_size, const char * s, const char * fmt, bool has_header=true, char delimiter=',', char quote_char='"');
+  CSV_Parser(void * pool, size_t pool_size, const char * fmt_, bool hh=true, char d=',', char qc='"') : CSV_Parser(pool, pool_size, 0, fmt_, hh, d, qc) {}
+
   /** @brief Releases all dynamically allocated memory.  
 	  Making values unusable once the CSV_Parser goes out of scope.  */
   ~CSV_Parser();
@@ -138,7 +514,102 @@ public:
   bool readSDfile(const char *f_name);
 #endif
 
+#ifdef NON_ARDUINO
+  /** @brief Reads file from disk (available only in non-Arduino builds). File is read by large blocks and parsed in place.
+      @param f_name - file path (provided file must have format that was supplied in CSV_Parser constructor)
+      @return True if file could be read, false if not.  */
+  bool readFile(const char *f_name);
+
+  /** @brief Reads csv from already opened file descriptor (e.g. a pipe or socket) until end of file is reached. 
+      The descriptor is not closed.
+      @return True if everything could be read, false if read error occurred.  */
+  bool readFd(int fd);
+
+  /** @brief Parses the whole csv string using multiple threads (available only in non-Arduino builds). The string is split 
+      into chunks at ends of rows (new lines within quoted values are recognized by counting quote chars), each chunk is 
+      parsed by a separate thread and rows of all chunks are then joined in the original order, so the result is the same as 
+      when the string is supplied with "cp << s".  
+      It must be used instead of supplying csv in other ways (it can't be combined with the memory pool, setRowCallback, setRowWindow, setColumnAggregate, addFilter or setStructArray).  
+      @param s - csv string (terminated by 0)  
+      @param threads (optional) - number of threads (0 = number of CPU cores), small strings use fewer threads 
+                                  (chunks are at least CSV_PARSER_PARALLEL_MIN_CHUNK_SIZE bytes long)  
+      @return false if the csv couldn't be parsed this way  */
+  bool parseParallel(const char * s, int threads = 0);
+
+  /** @brief Reads the whole file into memory and parses it with parseParallel.  */
+  bool readFileParallel(const char * f_name, int threads = 0);
+
+  /** @brief Maps the file into memory (read-only) and parses it in place (available only in non-Arduino builds). 
+      Strings aren't copied, values of "s" columns are CSV_String (pointer + length) pointing into the mapped file instead 
+      of char* (only quoted values containing escaped quote chars are copied, because they must be unescaped). 
+      The file stays mapped until the CSV_Parser object is destroyed.  
+      It must be used instead of supplying csv in other ways (it can't be combined with setRowWindow or setStructArray), but it can be 
+      combined with setRowCallback.  
+      @param f_name - file path (provided file must have format that was supplied in CSV_Parser constructor)
+      @return True if file could be mapped, false if not.  */
+  bool mapFile(const char * f_name);
+#endif
+
+  /** @brief Saves parsed values (and keys) in binary form, so they can be restored by loadSnapshot without parsing 
+      the csv again (e.g. at the next boot), like:  
+            File f = SD.open("values.bin", FILE_WRITE); cp.saveSnapshot(f); f.close();  
+      Values are saved as they're stored in memory, so the snapshot can be loaded only on the same architecture.  
+      @return false if writing failed or if rows aren't stored in values arrays (setRowCallback, setRowWindow, setColumnAggregate, setStructArray)  */
+  bool saveSnapshot(Stream & out);
+
+  /** @brief Restores values saved by saveSnapshot. They're read directly into values arrays, without any parsing or conversion.  
+      The parser must be constructed with the same format and no csv may be supplied before (rows supplied after are appended).  
+      @return false if the snapshot was saved with a different format, couldn't be read or memory couldn't be allocated 
+              (the parser is then left unchanged, so the csv can be parsed instead)  */
+  bool loadSnapshot(Stream & in);
+
+#ifdef NON_ARDUINO
+  /** @brief Saves the snapshot to a file (available only in non-Arduino builds).  */
+  bool saveSnapshot(const char * f_name);
+
+  /** @brief Loads the snapshot from a file (available only in non-Arduino builds), the file is mapped into memory.  */
+  bool loadSnapshot(const char * f_name);
+#endif
+
+  /** @brief Sets the function moving the csv source (supplying csv to the function set by setFillBufferCallback) to the given 
+      byte offset, like:  
+            bool seekFile(uint32_t position) { return file.seek(position); }  
+      It's used by buildRowIndex and readRows.  */
+  void setSeekCallback(SeekCallback seek_callback);
+
+  /** @brief Reads the whole csv (using the fill buffer and seek callbacks) and remembers byte offsets of every "rows_per_entry"-th 
+      row, so readRows can start reading close to any row. Quoted values (including new lines within them) are recognized, 
+      but rows are assumed to end with a new line (rows with missing values aren't continued on the next line).  
+      Values aren't parsed (rows are skipped like unused values), memory needed is 4 bytes per indexed row.  
+      @return false if memory could not be allocated or the csv couldn't be read  */
+  bool buildRowIndex(int rows_per_entry);
+
+  /** @brief Parses "count" rows starting with the row "start" (0 being the first row after header) into values arrays 
+      (replacing previously parsed rows), using the row index. Only the rows between the nearest indexed row and "start" 
+      are read before them (without parsing their values). Header is parsed at the first call.  
+      @return false if no row could be read (e.g. "start" is beyond the last row or the row index wasn't built/loaded)  */
+  bool readRows(uint32_t start, int count);
+
+  /** @brief Number of rows (excluding header) found by buildRowIndex.  */
+  uint32_t getIndexedRowsCount();
+
+  /** @brief Saves the row index (e.g. to a file next to the csv), so it doesn't have to be built again.  */
+  bool saveRowIndex(Stream & out);
+
+  /** @brief Loads the row index saved by saveRowIndex.  */
+  bool loadRowIndex(Stream & in);
+
+#ifdef NON_ARDUINO
+  /** @brief Saves the row index to a file (available only in non-Arduino builds).  */
+  bool saveRowIndex(const char * f_name);
+
+  /** @brief Loads the row index from a file (available only in non-Arduino builds).  */
+  bool loadRowIndex(const char * f_name);
+#endif
+
   /** @brief Reads a single row provided by the user-defined functions: feedRowParser (returns char to be supplied) and rowParserFinished (returns whether all rows were parsed)
+      or by the function set with setFillBufferCallback (which is much faster, because csv is supplied by blocks instead of single chars).  
+      Rows remaining from the previously supplied block are returned without calling any of these functions.  
       @return true if row was parsed, false if not (e.g. if rowParserFinished() returned true) 
      */
   bool parseRow();
@@ -148,6 +619,63 @@ public:
   /**  @brief Excluding header (if it was part of supplied CSV).  */
   int getRowsCount();
   
+  /**  @brief Preallocates values arrays for the given number of rows (useful when the number of rows is known up front).  
+       Without it, arrays grow geometrically (by half of their size) when they're full.  
+       @param rows - number of rows (excluding header)  
+       @return false if memory could not be allocated  */
+  bool reserve(int rows);
+
+  /**  @brief Releases the unused capacity of values arrays (e.g. after the whole csv was parsed).  */
+  void shrinkToFit();
+
+  /**  @brief Makes the parser keep only the last "rows" rows (e.g. when parsing a never-ending stream of sensor data). 
+       All memory needed for them is allocated by this call, strings are stored in fixed size slots (longer ones are truncated), 
+       so memory usage stays constant no matter how many rows are parsed. It must be called before any csv is supplied.  
+       Values arrays become circular buffers, the position of a row within them is returned by getRowPosition, like:  
+              for (uint32_t i = cp.getOldestRowIndex(); i <= cp.getNewestRowIndex(); i++) 
+                  float temperature = temperatures[cp.getRowPosition(i)];  
+       getRowsCount() returns the number of rows currently kept (at most "rows"). Kept rows can be read at any time, also while 
+       the next row is only partly supplied (the row being parsed is stored in an extra slot until it's complete).  
+       @param rows - number of rows kept  
+       @param max_string_len - maximum length of strings (excluding terminating 0)  
+       @return false if memory could not be allocated or the row callback/struct array is used (they can't be combined)  */
+  bool setRowWindow(int rows, int max_string_len);
+
+  /**  @brief Returns the index of the oldest row that is kept (rows are indexed from 0 since the first row after header). 
+       Without setRowWindow it's always 0.  */
+  uint32_t getOldestRowIndex();
+
+  /**  @brief Returns the index of the most recently parsed row (it's valid only when getRowsCount() > 0).  */
+  uint32_t getNewestRowIndex();
+
+  /**  @brief Returns the number of rows that were overwritten by newer rows (equal to getOldestRowIndex()).  */
+  uint32_t getDroppedRowsCount();
+
+  /**  @brief Returns the position of the row within values arrays given its index, like:  
+              int32_t my_value = ((int32_t*)cp["my_key"])[cp.getRowPosition(cp.getNewestRowIndex())];  
+       @return position or -1 if the row isn't kept (anymore)  */
+  int getRowPosition(uint32_t row_index);
+
+  /**  @brief Returns true if any memory allocation failed (e.g. when the memory pool was exhausted). 
+       Rows that couldn't be stored are not included in getRowsCount().  */
+  bool outOfMemory();
+
+  /**  @brief Returns the maximum number of bytes that were used from the memory pool at any point (0 if the pool isn't used).  
+       It's useful for finding the right size of the pool.  */
+  size_t highWaterMark();
+
+  /**  @brief Returns the number of numeric values that were invalid (e.g. "12a" or "abc") or out of range of their type (e.g. "300" stored as "uc").  
+       Out of range values are saturated (e.g. to 255), digits preceding invalid characters are still converted (e.g. "12a" gives 12).
+       Empty values are converted to 0 and they aren't counted.  */
+  int getConversionErrorsCount();
+
+#ifdef CSV_PARSER_ENABLE_STATS
+  /**  @brief Returns statistics of parsing so far: numbers of parsed bytes/rows/values, memory allocations, memory used by the 
+       parser (excluding allocator overhead) and times spent in parsing phases (available only when CSV_PARSER_ENABLE_STATS is defined). 
+       Timing adds a few clock reads per value, so parsing is slower when statistics are enabled.  */
+  CSV_Stats getStats();
+#endif
+
   /**  @brief Gets values given the column key name.  
        @param key - column name  
        @return pointer to the first value (it must be cast by the user)   */
@@ -160,13 +688,28 @@ public:
   
   /**  @brief It's the same as GetValues(key) but allows to use operator instead of method call, like:  
               int32_t * my_values = (int32_t*)cp["my_key"];                 
-       @param key - column name   */
+       @param key - column name   
+       Important: values arrays are reallocated when they grow, so pointers returned by it (and by all other "getValues" methods) 
+       become invalid when more csv is supplied (and after reserve/shrinkToFit calls). They should be retrieved after parsing.  */
   void * operator [] (const char *key);
  
   /**  @brief It's the same as GetValues(col_index) but allows to use operator instead of method call, like:  
               int32_t * my_values = (int32_t*)cp[0];  
        @param col_index - column index (0 being the first column)   */ 
   void * operator [] (int col_index);
+
+  /**  @brief Gets values of the column returned by getColumn, like:  
+              CSV_Column column = cp.getColumn("my_key");  
+              int32_t * my_values = (int32_t*)cp[column];  */
+  void * operator [] (const CSV_Column & column);
+
+  /**  @brief Finds column by its name (in constant time, names are hashed when the header is parsed).  
+       @param key - column name  
+       @return handle of the column (handle.found() returns false if there's no such column)  */
+  CSV_Column getColumn(const char * key);
+
+  /**  @brief Returns handle of the column given its index (0 being the first column).  */
+  CSV_Column getColumn(int col_index);
   
   void printKeys(Stream &ser = Serial);
   
@@ -217,6 +760,96 @@ public:
   void setFeedRowParserStrCallback(FeedRowParserStrCallback feedRowParserStr_callback);
   void setRowParserFinishedCallback(RowParserFinishedCallback rowParserFinished_callback);
 
+  /**  @brief Sets the function supplying csv to parseRow by blocks (instead of feedRowParser and rowParserFinished), like:  
+              size_t fillBuffer(char * buf, size_t capacity) { return file.read((uint8_t*)buf, capacity); }  
+       The function must write at most "capacity" chars to "buf" (CSV_PARSER_READ_BLOCK_SIZE at most) and return their number, 
+       returning 0 means that the end of csv was reached.  */
+  void setFillBufferCallback(FillBufferCallback fillBuffer_callback);
+
+  /**  @brief Makes the parser pass each row to the callback (as soon as the row is complete) instead of storing it, so 
+       memory usage doesn't depend on the number of rows. Numbers are already converted, strings are passed as CSV_String 
+       (pointer + length) pointing into the supplied csv. The row (including its strings) is valid only during the callback.  
+       It must be called before any csv is supplied (so it can't be used with the constructor that takes the whole csv string). 
+       getRowsCount() stays 0. It can't be combined with setRowWindow or setStructArray.  
+       @param callback - function called for every row (excluding header), like:  
+              void onRow(CSV_Row & row, void * user_data) { int32_t id = *(int32_t*)row["id"]; CSV_String name = *(CSV_String*)row[1]; }  
+       @param user_data (optional) - pointer passed to the callback  
+       @return false if memory could not be allocated or the row window/struct array is used  */
+  bool setRowCallback(CSV_RowCallback callback, void * user_data = 0);
+
+  /**  @brief Makes the parser compute running statistics (count, min, max, sum, mean, variance) of the numeric column 
+       instead of storing its values, so memory usage of the column doesn't depend on the number of rows. Values are 
+       converted the same way as when they're stored (according to the column type), the values array of the column 
+       holds only the last value. Other columns are stored as usual (use "-" for columns that aren't needed).  
+       It must be called before any row is supplied (the header may already be parsed, so the column can be given by its key).  
+       Columns preceding a filtered column can't be aggregated (their values are added before the row could be rejected, see addFilter).  
+       @param col_index - index of the column (it can't be "s", "-" or "a" column)  
+       @return false if the column can't be aggregated or if memory could not be allocated  */
+  bool setColumnAggregate(int col_index);
+  bool setColumnAggregate(const char * key);
+
+  /**  @brief Returns running statistics of the column set with setColumnAggregate, they can be checked at any time 
+       (e.g. between supplied chunks), like:  
+              CSV_Aggregate t = cp.getAggregate("temperature"); float mean = t.mean; float std_dev = sqrt(t.variance());  
+       @return statistics (all 0 if the column isn't aggregated or no value was parsed yet)  */
+  CSV_Aggregate getAggregate(int col_index);
+  CSV_Aggregate getAggregate(const char * key);
+
+  /**  @brief Makes the parser keep only rows whose value in the column matches the filter, other rows are discarded while 
+       they're parsed (before their remaining values are converted or stored), like:  
+              cp.addFilter("temperature", CSV_GREATER, "25.5"); cp.addFilter("city", CSV_EQUAL, "Paris");  
+       Values of numeric columns are compared as numbers (invalid or empty values don't match), values of "s" and "-" columns 
+       are compared as strings (ordering compares chars). A row is kept only if it matches all filters, rejected rows aren't 
+       stored, passed to the row callback or counted by getRowsCount() (with setRowWindow they don't overwrite kept rows).  
+       It must be called before any row is supplied (the header may already be parsed, so the column can be given by its key). 
+       Filtered columns can't follow aggregated columns (see setColumnAggregate), parseParallel can't be used with filters.  
+       @param col_index - index of the column ("-" columns can be given only by index)  
+       @param op - comparison, e.g. CSV_LESS keeps rows whose value is less than "value"  
+       @param value - value compared with values of the column (it's copied)  
+       @return false if the column doesn't exist, "value" isn't a valid number of numeric column or memory could not be allocated  */
+  bool addFilter(int col_index, CSV_FilterOp op, const char * value);
+  bool addFilter(const char * key, CSV_FilterOp op, const char * value);
+
+  /**  @brief Returns the number of rows that matched filters added by addFilter (all parsed rows if there are no filters).  */
+  uint32_t getAcceptedRowsCount();
+
+  /**  @brief Returns the number of rows that didn't match filters added by addFilter.  */
+  uint32_t getRejectedRowsCount();
+
+  /**  @brief Makes the parser write values of bound columns (see bindColumn) directly into an array of structs, one struct 
+       per row, instead of separate values arrays. It avoids copying parsed rows into structs, like:  
+              struct Reading { int32_t time; float value; };  
+              Reading readings[100];  
+              cp.setStructArray(readings, sizeof(Reading), 100);  
+              cp.bindColumn("time", offsetof(Reading, time));  
+              cp.bindColumn("value", offsetof(Reading, value));  
+       Rows that don't fit in the array are dropped (outOfMemory() returns true).  
+       It must be called before any row is supplied, it can't be used with setRowCallback, setRowWindow, mapFile, parseParallel 
+       or snapshots.  
+       @param structs - array of structs supplied by the user  
+       @param struct_size - size of a single struct (e.g. sizeof(Reading))  
+       @param capacity - number of structs in the array  
+       @return false if the parser can't use the array  */
+  bool setStructArray(void * structs, size_t struct_size, int capacity);
+
+  /**  @brief The same as above, but the array is allocated by the parser and it grows as rows are parsed (like values arrays), 
+       use getStructArray() to access it (its address changes when it grows).  
+       @return false if memory could not be allocated  */
+  bool setStructArray(size_t struct_size);
+
+  /**  @brief Returns the array of structs set with setStructArray (0 if there's none), like:  
+              Reading * readings = (Reading*)cp.getStructArray(); // cp.getRowsCount() structs are filled  */
+  void * getStructArray();
+
+  /**  @brief Makes the parser write values of the column into the field of the struct at the given offset (see setStructArray). 
+       The field must have the type of the column (e.g. float for "f", char* for "s"). Values arrays of bound columns 
+       aren't filled (cp[key] can't be used for them).  
+       @param col_index - index of the column (it can't be "-", "a" or aggregated column)  
+       @param offset - offset of the field within the struct, e.g. offsetof(Reading, value)  
+       @return false if the column can't be bound (e.g. the field doesn't fit in the struct) or memory could not be allocated  */
+  bool bindColumn(int col_index, size_t offset);
+  bool bindColumn(const char * key, size_t offset);
+
   /**  @brief If invalid parameters are supplied to this class, then debug serial is used to output error information.   
 	   This function is static, which means that it supposed to be called like:  
 	   CSV_Parser::SetDebugSerial(stream_object);  
@@ -226,8 +859,136 @@ public:
 
 };
 
+/** @brief Row passed to the callback set by CSV_Parser::setRowCallback. Values are accessed the same way as with CSV_Parser, 
+    except that the returned pointer points to a single value (e.g. *(float*)row["temperature"]). Values of "s" columns are CSV_String.  */
+class CSV_Row {
+  CSV_Parser & cp;
+  int index;
+  CSV_Row(CSV_Parser & cp_, int index_) : cp(cp_), index(index_) {}
+  friend class CSV_Parser;
+public:
+  /** @brief Index of the row (0 being the first row after header).  */
+  int getIndex() const { return index; }
+  int getColumnsCount() const { return cp.getColumnsCount(); }
+
+  const void * operator [] (int col_index) const { return cp[col_index]; }
+  const void * operator [] (const char * key) const { return cp[key]; }
+  const void * operator [] (const CSV_Column & column) const { return cp[column]; }
+};
+
 
+/*  Typed front-end. Column types are given as template parameters instead of the format string, e.g.:  
+
+      CSV_ParserT<char*, CSV_Skip, float> cp;    // same as CSV_Parser cp("s-f");
+      cp << csv_str;
+      float * values = cp.get<2>();              // no casting needed
+
+    Types are checked at compile time (unsupported type or index results in compilation error). The store function of 
+    each column is selected at compile time from its type (CSV_Parser selects them from the format string at run time), 
+    so only conversions of the used types are referenced (the linker drops the others) and "-" columns have none. 
+    The tokenizer is shared with CSV_Parser. It requires C++11 (which is used by Arduino IDE since 1.6.6).  */
+
+/** @brief Tag types for CSV_ParserT columns which don't map to a distinct C++ type.  */
+struct CSV_Skip {}; // unused column ("-"), values are not stored
+struct CSV_Hex {};  // hex value stored as int32_t ("x")
+struct CSV_UHex {}; // hex value stored as uint32_t ("ux")
+template<uint8_t Scale> struct CSV_Fixed {};  // fixed-point value with "Scale" decimal places stored as int32_t (e.g. "q2" for CSV_Fixed<2>)
+template<uint8_t Scale> struct CSV_UFixed {}; // fixed-point value stored as uint32_t ("uq")
+
+/*  Maps types of CSV_ParserT columns to format specifiers.  */
+template<typename T> struct CSV_ColumnType; // not defined for unsupported types
+template<> struct CSV_ColumnType<char*>    { typedef char*    value_type; static const char specifier = 's'; static const bool is_unsigned = false; };
+template<> struct CSV_ColumnType<float>    { typedef float    value_type; static const char specifier = 'f'; static const bool is_unsigned = false; };
+template<> struct CSV_ColumnType<int32_t>  { typedef int32_t  value_type; static const char specifier = 'L'; static const bool is_unsigned = false; };
+template<> struct CSV_ColumnType<uint32_t> { typedef uint32_t value_type; static const char specifier = 'L'; static const bool is_unsigned = true;  };
+template<> struct CSV_ColumnType<int16_t>  { typedef int16_t  value_type; static const char specifier = 'd'; static const bool is_unsigned = false; };
+template<> struct CSV_ColumnType<uint16_t> { typedef uint16_t value_type; static const char specifier = 'd'; static const bool is_unsigned = true;  };
+template<> struct CSV_ColumnType<char>     { typedef char     value_type; static const char specifier = 'c'; static const bool is_unsigned = false; };
+template<> struct CSV_ColumnType<int8_t>   { typedef int8_t   value_type; static const char specifier = 'c'; static const bool is_unsigned = false; };
+template<> struct CSV_ColumnType<uint8_t>  { typedef uint8_t  value_type; static const char specifier = 'c'; static const bool is_unsigned = true;  };
+template<> struct CSV_ColumnType<CSV_Hex>  { typedef int32_t  value_type; static const char specifier = 'x'; static const bool is_unsigned = false; };
+template<> struct CSV_ColumnType<CSV_UHex> { typedef uint32_t value_type; static const char specifier = 'x'; static const bool is_unsigned = true;  };
+template<> struct CSV_ColumnType<CSV_Skip> { typedef void     value_type; static const char specifier = '-'; static const bool is_unsigned = false; };
+template<uint8_t S> struct CSV_ColumnType<CSV_Fixed<S> >  { typedef int32_t  value_type; static const char specifier = 'q'; static const bool is_unsigned = false; };
+template<uint8_t S> struct CSV_ColumnType<CSV_UFixed<S> > { typedef uint32_t value_type; static const char specifier = 'q'; static const bool is_unsigned = true;  };
+
+/*  Scale digit following the specifier of fixed-point columns (0 for other columns).  */
+template<typename T> struct CSV_ColumnScale { static const uint8_t value = 0; };
+template<uint8_t S> struct CSV_ColumnScale<CSV_Fixed<S> >  { static_assert(S <= 9, "scale must be a single digit"); static const uint8_t value = S; };
+template<uint8_t S> struct CSV_ColumnScale<CSV_UFixed<S> > { static_assert(S <= 9, "scale must be a single digit"); static const uint8_t value = S; };
+
+/*  Chars of the format string, built at compile time (so the string is constant-initialized and can't be raced for 
+    when CSV_ParserT objects are constructed by separate threads).  */
+template<char... C> struct CSV_FormatChars { static constexpr char value[sizeof...(C) + 1] = { C..., 0 }; };
+template<char... C> constexpr char CSV_FormatChars<C...>::value[sizeof...(C) + 1];
+
+/*  Format chars of a single column: "u" prefix of unsigned columns and scale digit of fixed-point columns.  */
+template<bool IsUnsigned, char Specifier, uint8_t Scale> struct CSV_ColumnFormat { typedef CSV_FormatChars<Specifier> type; };
+template<char Specifier, uint8_t Scale> struct CSV_ColumnFormat<true, Specifier, Scale> { typedef CSV_FormatChars<'u', Specifier> type; };
+template<uint8_t Scale> struct CSV_ColumnFormat<false, 'q', Scale> { typedef CSV_FormatChars<'q', (char)('0' + Scale)> type; };
+template<uint8_t Scale> struct CSV_ColumnFormat<true, 'q', Scale>  { typedef CSV_FormatChars<'u', 'q', (char)('0' + Scale)> type; };
+
+/*  Joins format chars of all columns.  */
+template<typename... Lists> struct CSV_JoinFormat { typedef CSV_FormatChars<> type; };
+template<char... A> struct CSV_JoinFormat<CSV_FormatChars<A...> > { typedef CSV_FormatChars<A...> type; };
+template<char... A, char... B, typename... Rest> struct CSV_JoinFormat<CSV_FormatChars<A...>, CSV_FormatChars<B...>, Rest...> { 
+  typedef typename CSV_JoinFormat<CSV_FormatChars<A..., B...>, Rest...>::type type; 
+};
+
+/*  Type of the I-th element of the list.  */
+template<int I, typename T, typename... Rest> struct CSV_TypeAt { typedef typename CSV_TypeAt<I - 1, Rest...>::type type; };
+template<typename T, typename... Rest> struct CSV_TypeAt<0, T, Rest...> { typedef T type; };
 
+template<typename... T>
+class CSV_ParserT : public CSV_Parser {
+public:
+  /** @brief Constructor for supplying csv string by chunks (or all at once with "cp << csv_str").  */
+  CSV_ParserT(bool has_header = true, char delimiter = ',', char quote_char = '"') : 
+    CSV_Parser((void*)0, 0, format(), stores(), has_header, delimiter, quote_char) {}
+
+  /** @brief Constructor using memory pool supplied by the user (see the corresponding CSV_Parser constructor).  */
+  CSV_ParserT(void * pool, size_t pool_size, bool has_header = true, char delimiter = ',', char quote_char = '"') : 
+    CSV_Parser(pool, pool_size, format(), stores(), has_header, delimiter, quote_char) {}
+
+  /** @brief Gets values of the I-th column (starting with 0).  
+      @return pointer to the first value (e.g. float* for "float" column, int32_t* for "CSV_Hex" column)  */
+  template<int I>
+  typename CSV_ColumnType<typename CSV_TypeAt<I, T...>::type>::value_type * get() {
+    static_assert(CSV_ColumnType<typename CSV_TypeAt<I, T...>::type>::specifier != '-', "values of CSV_Skip columns are not stored");
+    return (typename CSV_ColumnType<typename CSV_TypeAt<I, T...>::type>::value_type *)(*this)[I];
+  }
+
+  /** @brief Returns the format string equivalent to the column types (e.g. "s-fq2" for <char*, CSV_Skip, float, CSV_Fixed<2>>).  */
+  static const char * format() {
+    return CSV_JoinFormat<typename CSV_ColumnFormat<CSV_ColumnType<T>::is_unsigned, CSV_ColumnType<T>::specifier, 
+                                                    CSV_ColumnScale<T>::value>::type...>::type::value;
+  }
+
+private:
+  /*  Store function of each column type (overloads of types that aren't used aren't instantiated).  */
+  typedef CSV_Parser::ColumnStore Store;
+  template<typename C> struct Tag {};
+  static constexpr Store storeOf(Tag<char*>)    { return &CSV_Parser::storeString; }
+  static constexpr Store storeOf(Tag<float>)    { return &CSV_Parser::storeFloat; }
+  static constexpr Store storeOf(Tag<int32_t>)  { return &CSV_Parser::storeInteger<int32_t, 10>; }
+  static constexpr Store storeOf(Tag<uint32_t>) { return &CSV_Parser::storeInteger<uint32_t, 10>; }
+  static constexpr Store storeOf(Tag<int16_t>)  { return &CSV_Parser::storeInteger<int16_t, 10>; }
+  static constexpr Store storeOf(Tag<uint16_t>) { return &CSV_Parser::storeInteger<uint16_t, 10>; }
+  static constexpr Store storeOf(Tag<char>)     { return &CSV_Parser::storeInteger<int8_t, 10>; }
+  static constexpr Store storeOf(Tag<int8_t>)   { return &CSV_Parser::storeInteger<int8_t, 10>; }
+  static constexpr Store storeOf(Tag<uint8_t>)  { return &CSV_Parser::storeInteger<uint8_t, 10>; }
+  static constexpr Store storeOf(Tag<CSV_Hex>)  { return &CSV_Parser::storeInteger<int32_t, 16>; }
+  static constexpr Store storeOf(Tag<CSV_UHex>) { return &CSV_Parser::storeInteger<uint32_t, 16>; }
+  static constexpr Store storeOf(Tag<CSV_Skip>) { return 0; }
+  template<uint8_t S> static constexpr Store storeOf(Tag<CSV_Fixed<S> >)  { return &CSV_Parser::storeFixed<int32_t>; }
+  template<uint8_t S> static constexpr Store storeOf(Tag<CSV_UFixed<S> >) { return &CSV_Parser::storeFixed<uint32_t>; }
+
+  /*  Constant-initialized like the format string (the last element only avoids an empty array).  */
+  static const Store * stores() {
+    static constexpr Store list[] = { storeOf(Tag<T>())..., 0 };
+    return list;
+  }
+};
 
 
 #endif
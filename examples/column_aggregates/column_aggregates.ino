@@ -0,0 +1,55 @@
+/*  column_aggregates example for: https://github.com/michalmonday/CSV-Parser-for-Arduino
+
+Statistics (count, min, max, sum, mean, variance) of numeric columns are computed while parsing,
+values of aggregated columns aren't stored, so memory usage doesn't grow with the number of rows.
+
+Rows of a sensor log are generated here (like rows read from a file or received over serial),
+statistics are printed after every 1000 rows.
+
+*/
+#include <CSV_Parser.h>
+
+// "time" and "status" columns aren't needed ("-"), "temperature" is float, "pressure" is uint16_t
+CSV_Parser cp(/*format*/ "-fud-");
+uint32_t row = 0;
+
+void printAggregate(const char * key) {
+  CSV_Aggregate a = cp.getAggregate(key);
+  Serial.print(key);
+  Serial.print(": count=");
+  Serial.print(a.count);
+  Serial.print(", min=");
+  Serial.print(a.min);
+  Serial.print(", max=");
+  Serial.print(a.max);
+  Serial.print(", mean=");
+  Serial.print(a.mean);
+  Serial.print(", std dev=");
+  Serial.println(sqrt(a.variance()));
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  // columns are selected before any row is supplied (by index, or by key once the header was parsed)
+  cp << "time,temperature,pressure,status\n";
+  if (!cp.setColumnAggregate("temperature") || !cp.setColumnAggregate("pressure")) {
+    Serial.println("ERROR: setColumnAggregate failed");
+    while (1);
+  }
+}
+
+void loop() {
+  char line[48];
+  snprintf(line, sizeof(line), "%lu,%d.%d,%u,ok\n", (unsigned long)row, 20 + (int)random(5), (int)random(10), 1000 + (unsigned)random(30));
+  cp << line;
+
+  if (++row % 1000 == 0) {
+    Serial.print("After ");
+    Serial.print(row);
+    Serial.println(" rows:");
+    printAggregate("temperature");
+    printAggregate("pressure");
+  }
+}
@@ -1,10 +1,13 @@
 /*  parsing_row_by_row example for: https://github.com/michalmonday/CSV-Parser-for-Arduino
 
-The user must define the following 2 functions/callbacks:
-- char feedRowParser()
-- bool rowParserFinished()
+The file is supplied to cp.parseRow() by blocks with the function set by "cp.setFillBufferCallback(fillBuffer)":
+- size_t fillBuffer(char * buf, size_t capacity)
 
-That is because cp.parseRow() calls these functions continuously "under the hood".
+It writes at most "capacity" chars into "buf" and returns their number (0 at the end of the file). 
+parseRow calls it only when the previously supplied block doesn't contain the next row.
+
+(Supplying single chars with "char feedRowParser()" and "bool rowParserFinished()" functions works too, 
+but it's much slower, see the parsing_row_by_row example)
 
 */
 #include <CSV_Parser.h>
@@ -32,11 +35,9 @@ Accessing values by column name:
 const char * f_name = "/file4.csv";
 const int chipSelect = 10;
 File file;
-char feedRowParser() {
-  return file.read();
-}
-bool rowParserFinished() {
-  return ((file.available()>0)?false:true);
+size_t fillBuffer(char * buf, size_t capacity) {
+  int n = file.read((uint8_t*)buf, capacity);
+  return n > 0 ? n : 0;
 }
  
 void setup() {
@@ -66,9 +67,9 @@ void setup() {
   //CSV_Parser cp(/*format*/ "Lsssssssssss");
 
   CSV_Parser cp(/*format*/ "Ls-------s--");
+  cp.setFillBufferCallback(fillBuffer);
 
-  // parseRow calls feedRowParser() continuously until it reads a 
-  // full row or until the rowParserFinished() returns true
+  // parseRow calls fillBuffer() until it reads a full row or until fillBuffer() returns 0
   int row_index = 0;
 
   // WARNING: String indexing can't be used here because the header was not supplied to the cp object yet.
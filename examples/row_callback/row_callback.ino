@@ -0,0 +1,59 @@
+/*  Example showing how to process rows with a callback for: https://github.com/michalmonday/CSV-Parser-for-Arduino
+
+    After "setRowCallback" is called, the parser doesn't store rows. Each row is passed to the callback as soon as 
+    it's complete and it's overwritten by the next row, so csv of any length can be processed in constant memory 
+    (e.g. a log read from SD card by small chunks).
+
+    Values of the row are accessed like values of CSV_Parser, except that the returned pointer points to a single value:
+      int32_t id = *(int32_t*)row["id"];
+    Strings ("s" columns) are passed as CSV_String (pointer + length), they aren't terminated by 0.
+    The row (including its strings) must not be used after the callback returns.
+*/
+
+#include <CSV_Parser.h>
+
+struct Totals {
+  int32_t sum;
+  float max_temperature;
+};
+
+void onRow(CSV_Row & row, void * user_data) {
+  Totals * totals = (Totals*)user_data;
+
+  int32_t    id          = *(int32_t*)row["id"];
+  CSV_String name        = *(CSV_String*)row["name"];
+  float      temperature = *(float*)row[2];
+
+  totals->sum += id;
+  if (temperature > totals->max_temperature)
+    totals->max_temperature = temperature;
+
+  Serial.print(row.getIndex(), DEC);
+  Serial.print(". ");
+  Serial.write(name.s, name.len);
+  Serial.print(" - ");
+  Serial.println(temperature);
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  Totals totals = {0, -1000.0};
+  CSV_Parser cp(/*format*/ "Lsf");
+  cp.setRowCallback(onRow, &totals); // it must be called before supplying csv
+
+  // rows may be split between chunks in any way
+  cp << "id,name,temperature\n1,kitc" << "hen,21.5\n2,\"garden, north\",14.25\n3,garage,";
+  cp << "9.0\n";
+  cp.parseLeftover();
+
+  Serial.print("Sum of ids = ");
+  Serial.println(totals.sum, DEC);
+  Serial.print("Max temperature = ");
+  Serial.println(totals.max_temperature);
+}
+
+void loop() {
+
+}
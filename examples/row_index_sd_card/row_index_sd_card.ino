@@ -0,0 +1,88 @@
+/*  row_index_sd_card example for: https://github.com/michalmonday/CSV-Parser-for-Arduino
+
+Rows of a large file are looked up without parsing all rows preceding them. 
+"cp.buildRowIndex(rows_per_entry)" reads the file once and remembers byte offsets of every "rows_per_entry"-th row 
+(the index is saved to another file, so at the next boot it's just loaded with "cp.loadRowIndex(file)"). 
+"cp.readRows(start, count)" then moves to the nearest indexed row (with the seek callback) and parses only the requested rows.
+
+The file is supplied by the functions set with:
+- cp.setFillBufferCallback(fillBuffer) - reads the next block of the file
+- cp.setSeekCallback(seekFile)         - moves to the given position in the file
+
+*/
+#include <CSV_Parser.h>
+
+#include <SPI.h>
+#include <SD.h>
+
+// /file4.csv is the "/customers-100.csv" file from: https://github.com/datablist/sample-csv-files
+const char * f_name = "/file4.csv";
+const char * index_f_name = "/file4.idx";
+const int chipSelect = 10;
+File file;
+
+size_t fillBuffer(char * buf, size_t capacity) {
+  int n = file.read((uint8_t*)buf, capacity);
+  return n > 0 ? n : 0;
+}
+
+bool seekFile(uint32_t position) {
+  return file.seek(position);
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  if (!SD.begin(chipSelect)) {
+    Serial.println("ERROR: Card failed, or not present");
+    while (1);
+  }
+
+  CSV_Parser cp(/*format*/ "Ls-------s--");
+  cp.setFillBufferCallback(fillBuffer);
+  cp.setSeekCallback(seekFile);
+
+  File index_file = SD.open(index_f_name, FILE_READ);
+  bool index_loaded = index_file && cp.loadRowIndex(index_file);
+  index_file.close();
+
+  file = SD.open(f_name, FILE_READ);
+  if (!file) {
+    Serial.println("ERROR: File open failed");
+    while (1);
+  }
+
+  if (!index_loaded) {
+    // memory needed is 4 bytes per indexed row
+    if (!cp.buildRowIndex(/*rows_per_entry*/ 10)) {
+      Serial.println("ERROR: Building row index failed");
+      while (1);
+    }
+    index_file = SD.open(index_f_name, FILE_WRITE);
+    if (index_file)
+      cp.saveRowIndex(index_file);
+    index_file.close();
+  }
+  Serial.print("Rows in the file: ");
+  Serial.println(cp.getIndexedRowsCount(), DEC);
+
+  unsigned long start = millis();
+  if (cp.readRows(/*start*/ 95, /*count*/ 3)) {
+    Serial.print("Rows 95-97 read in ");
+    Serial.print(millis() - start, DEC);
+    Serial.println(" ms:");
+    int32_t *ids = (int32_t*)cp["Index"];
+    char **emails = (char**)cp["Email"];
+    for (int row = 0; row < cp.getRowsCount(); row++) {
+      Serial.print(ids[row], DEC);
+      Serial.print(". email=");
+      Serial.println(emails[row]);
+    }
+  }
+  file.close();
+}
+
+void loop() {
+
+}
@@ -0,0 +1,53 @@
+/*  Example showing how to keep only the last rows of a never-ending csv stream for: https://github.com/michalmonday/CSV-Parser-for-Arduino
+
+    After "setRowWindow(rows, max_string_len)" is called, the parser keeps only the last "rows" rows. Values arrays become 
+    circular buffers (the newest row overwrites the oldest one), strings are stored in fixed size slots (longer strings 
+    are truncated). All memory is allocated by setRowWindow, so the parser can run for weeks without running out of memory.
+
+    Rows are indexed from 0 (the first row after header) and the index keeps growing:
+      cp.getOldestRowIndex()   - index of the oldest row that is kept (equal to cp.getDroppedRowsCount())
+      cp.getNewestRowIndex()   - index of the most recently parsed row
+      cp.getRowPosition(index) - position of the row within values arrays (-1 if it isn't kept anymore)
+*/
+
+#include <CSV_Parser.h>
+
+CSV_Parser cp(/*format*/ "Lsf");
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  // 5 rows, strings up to 8 chars long
+  if (!cp.setRowWindow(5, 8))
+    Serial.println("ERROR: not enough memory for the row window");
+  cp << "time,sensor,temperature\n";
+}
+
+void loop() {
+  // in a real application csv would be received, e.g. with: cp << (char)Serial.read();
+  static uint32_t seconds = 0;
+  cp << String(seconds) + ",kitchen," + String(20.0 + (seconds % 10) / 10.0) + "\n";
+  seconds++;
+
+  int32_t * times        = (int32_t*)cp["time"];
+  char   ** sensors      = (char**)cp["sensor"];
+  float   * temperatures = (float*)cp["temperature"];
+
+  float sum = 0;
+  for (uint32_t i = cp.getOldestRowIndex(); i <= cp.getNewestRowIndex(); i++)
+    sum += temperatures[cp.getRowPosition(i)];
+
+  int newest = cp.getRowPosition(cp.getNewestRowIndex());
+  Serial.print(times[newest]);
+  Serial.print(" - ");
+  Serial.print(sensors[newest]);
+  Serial.print(", average of the last ");
+  Serial.print(cp.getRowsCount());
+  Serial.print(" rows = ");
+  Serial.print(sum / cp.getRowsCount());
+  Serial.print(" (dropped rows = ");
+  Serial.print(cp.getDroppedRowsCount());
+  Serial.println(")");
+  delay(1000);
+}
@@ -0,0 +1,74 @@
+/*  snapshot_sd_card example for: https://github.com/michalmonday/CSV-Parser-for-Arduino
+
+The csv file is parsed only once. Parsed values are then saved with "cp.saveSnapshot(file)" to a binary file 
+and at the next boot they're restored with "cp.loadSnapshot(file)", which only reads them (without parsing 
+and converting numbers), so it's much faster than parsing the csv again.
+
+The parser loading the snapshot must be created with the same format as the one that saved it 
+(otherwise loadSnapshot returns false and the csv can be parsed again).
+
+*/
+#include <CSV_Parser.h>
+
+#include <SPI.h>
+#include <SD.h>
+
+// /file4.csv is the "/customers-100.csv" file from: https://github.com/datablist/sample-csv-files
+const char * csv_f_name = "/file4.csv";
+const char * snapshot_f_name = "/file4.bin";
+const int chipSelect = 10;
+
+bool loadSnapshot(CSV_Parser & cp) {
+  File file = SD.open(snapshot_f_name, FILE_READ);
+  if (!file)
+    return false;
+  bool loaded = cp.loadSnapshot(file);
+  file.close();
+  return loaded;
+}
+
+void saveSnapshot(CSV_Parser & cp) {
+  SD.remove(snapshot_f_name);
+  File file = SD.open(snapshot_f_name, FILE_WRITE);
+  if (!file || !cp.saveSnapshot(file))
+    Serial.println("ERROR: Saving snapshot failed");
+  file.close();
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  if (!SD.begin(chipSelect)) {
+    Serial.println("ERROR: Card failed, or not present");
+    while (1);
+  }
+
+  CSV_Parser cp(/*format*/ "Ls-------s--");
+  unsigned long start = millis();
+  if (loadSnapshot(cp)) {
+    Serial.print("Snapshot loaded in ");
+  } else {
+    // the parser is left unchanged when loading fails, so the csv can be parsed instead
+    if (!cp.readSDfile(csv_f_name)) {
+      Serial.println("ERROR: File \"" + String(csv_f_name) + "\" could not be read.");
+      while (1);
+    }
+    saveSnapshot(cp);
+    Serial.print("Csv parsed (and snapshot saved) in ");
+  }
+  Serial.print(millis() - start, DEC);
+  Serial.println(" ms");
+
+  int32_t *ids = (int32_t*)cp["Index"];
+  char **emails = (char**)cp["Email"];
+  for (int row = 0; row < cp.getRowsCount() && row < 5; row++) {
+    Serial.print(ids[row], DEC);
+    Serial.print(". email=");
+    Serial.println(emails[row]);
+  }
+}
+
+void loop() {
+
+}
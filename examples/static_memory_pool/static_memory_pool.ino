@@ -0,0 +1,48 @@
+/*  Example showing how to parse csv without using the heap for: https://github.com/michalmonday/CSV-Parser-for-Arduino
+
+    By default CSV_Parser allocates memory (for keys, values, strings and not yet parsed chunks) dynamically.
+    On boards with very little RAM (e.g. Arduino Uno) it may be preferable to give the parser a buffer 
+    (e.g. a static array) from which all of its memory will be carved. That way the amount of memory used 
+    by the parser is known at compile time and no time is spent on malloc/realloc calls.
+
+    If the pool is too small then rows that don't fit are not stored and cp.outOfMemory() returns true.
+    cp.highWaterMark() tells how many bytes of the pool were actually needed.
+*/
+
+#include <CSV_Parser.h>
+
+static uint8_t pool[256];
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  CSV_Parser cp(pool, sizeof(pool), /*format*/ "sL");
+
+  // memory given back to the pool isn't reused (apart from the most recently allocated block), 
+  // so preallocating values arrays is recommended when the number of rows is known
+  cp.reserve(3);
+
+  cp << "my_strings,my_numbers\n"
+     << "hello,5\n"
+     << "world,10\n"
+     << "noice,15\n";
+
+  char    **strings = (char**)cp["my_strings"];
+  int32_t *numbers = (int32_t*)cp["my_numbers"];
+
+  for(int row = 0; row < cp.getRowsCount(); row++) {
+    Serial.print(strings[row]);
+    Serial.print(" - ");
+    Serial.println(numbers[row], DEC);
+  }
+
+  Serial.print("Out of memory = ");
+  Serial.println(cp.outOfMemory() ? "true" : "false");
+  Serial.print("Bytes of the pool used = ");
+  Serial.println(cp.highWaterMark(), DEC);
+}
+
+void loop() {
+
+}
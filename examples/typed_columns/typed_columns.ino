@@ -0,0 +1,46 @@
+/*  Example showing how to specify column types as template parameters for: https://github.com/michalmonday/CSV-Parser-for-Arduino
+
+    CSV_ParserT takes the types of columns instead of the format string. They're checked at compile time and 
+    "get<column_index>()" returns pointer of the right type, so values don't have to be cast by the user.
+
+    Supported types:
+      char*       - string ("s")
+      float       - "f"
+      int32_t     - "L"       uint32_t - "uL"
+      int16_t     - "d"       uint16_t - "ud"
+      char/int8_t - "c"       uint8_t  - "uc"
+      CSV_Hex     - "x" (values stored as int32_t), CSV_UHex - "ux" (stored as uint32_t)
+      CSV_Skip    - "-" (unused column)
+*/
+
+#include <CSV_Parser.h>
+
+void setup() {
+  Serial.begin(115200);
+  delay(5000);
+
+  // the same as: CSV_Parser cp("s-fuc");
+  CSV_ParserT<char*, CSV_Skip, float, uint8_t> cp;
+
+  cp << "name,unused,temperature,humidity\n"
+     << "kitchen,x,21.5,40\n"
+     << "garden,y,14.25,85\n";
+
+  char    **names        = cp.get<0>();
+  float   *temperatures  = cp.get<2>();
+  uint8_t *humidities    = cp.get<3>();
+  // cp.get<1>() wouldn't compile, because values of CSV_Skip columns aren't stored
+
+  for (int row = 0; row < cp.getRowsCount(); row++) {
+    Serial.print(names[row]);
+    Serial.print(" - ");
+    Serial.print(temperatures[row]);
+    Serial.print(" C, ");
+    Serial.print(humidities[row], DEC);
+    Serial.println(" %");
+  }
+}
+
+void loop() {
+
+}
@@ -30,9 +30,27 @@
     virtual void println(int i, int base) = 0;
     virtual void println() = 0;
     virtual void printf(const char *fmt, ...) = 0;
+
+    // bulk versions (like in Arduino's Print/Stream), derived classes may override them with faster ones
+    virtual size_t write(const uint8_t *buf, size_t size) {
+      for (size_t i = 0; i < size; i++)
+        write(buf[i]);
+      return size;
+    }
+    virtual size_t readBytes(char *buf, size_t length) {
+      size_t count = 0;
+      while (count < length) {
+        int c = read();
+        if (c < 0)
+          break;
+        buf[count++] = (char)c;
+      }
+      return count;
+    }
   };
   class SerialClass : public Stream {
   public:
+    using Stream::write;
     void write(uint8_t c) { putchar(c); }
     // int available() { return ; }
     int read() { return getchar(); }
@@ -205,6 +205,414 @@ void chunked_supply_test() {
     Serial.println(F("Chunked supply test FAILED"));
     cp.print();
   }
+
+  // unparsed ending of a chunk that doesn't fit in the memory pool is dropped, the next chunk isn't scanned as its continuation
+  static char pool[256];
+  CSV_Parser cp2(pool, sizeof(pool), /*format*/ "s", /*has_header*/ false);
+  char long_value[152];
+  memset(long_value, 'x', sizeof(long_value) - 1);
+  long_value[0] = '"';
+  long_value[sizeof(long_value) - 1] = 0;
+  cp2 << long_value;
+  assert(cp2.outOfMemory());
+  cp2 << "\nab\ncd\n";
+  assert(cp2.getRowsCount() == 3);
+  assert(strcmp(((char**)cp2[0])[1], "ab") == 0 && strcmp(((char**)cp2[0])[2], "cd") == 0);
+}
+
+void reserve_test() {
+  Serial.println(F("Reserve and shrinkToFit test"));
+  CSV_Parser cp("L", /*has_header*/ false);
+  assert(cp.reserve(100));
+  int32_t * reserved = (int32_t*)cp[0];
+  for (int i = 0; i < 100; i++)
+    cp << String(i) + "\n";
+
+  // reserved array must not be reallocated while it has enough capacity
+  assert((int32_t*)cp[0] == reserved);
+  assert(cp.getRowsCount() == 100);
+
+  cp << "100\n";
+  cp.shrinkToFit();
+  int32_t * values = (int32_t*)cp[0];
+  assert(cp.getRowsCount() == 101);
+  for (int i = 0; i < 101; i++)
+    assert(values[i] == i);
+}
+
+void conversion_errors_test() {
+  Serial.println(F("Numeric conversion errors test"));
+  CSV_Parser cp("a,b,c,d\n"
+                " 12 ,300,-1,2.5e2\n"
+                "12a,,FFFFFFFF,x\n", /*format*/ "Lucxf");
+
+  int32_t * a = (int32_t*)cp["a"];
+  uint8_t * b = (uint8_t*)cp["b"];
+  int32_t * c = (int32_t*)cp["c"];
+  float   * d = (float*)cp["d"];
+  assert(cp.getRowsCount() == 2);
+  assert(a[0] == 12 && a[1] == 12);   // "12a" is invalid
+  assert(b[0] == 255 && b[1] == 0);   // "300" is saturated, empty value isn't an error
+  assert(c[0] == -1 && c[1] == -1);   // signed hex values can use all 32 bits
+  assert(d[0] == 250.0f && d[1] == 0); // "x" is invalid
+  assert(cp.getConversionErrorsCount() == 3);
+}
+
+void typed_parser_test() {
+  Serial.println(F("CSV_ParserT test"));
+  CSV_ParserT<char*, CSV_Skip, float, uint8_t, CSV_Hex, int16_t> cp;
+  assert(strcmp(cp.format(), "s-fucxd") == 0);
+  cp << "a,b,c,d,e,f\n"
+        "hello,x,1.5,200,FF,-3\n"
+        "world,y,2.5,7,10,4\n";
+
+  char    ** a = cp.get<0>();
+  float   *  c = cp.get<2>();
+  uint8_t *  d = cp.get<3>();
+  int32_t *  e = cp.get<4>();
+  int16_t *  f = cp.get<5>();
+  assert(cp.getRowsCount() == 2);
+  assert(strcmp(a[0], "hello") == 0 && strcmp(a[1], "world") == 0);
+  assert(c[0] == 1.5f && c[1] == 2.5f);
+  assert(d[0] == 200 && d[1] == 7);
+  assert(e[0] == 255 && e[1] == 16);
+  assert(f[0] == -3 && f[1] == 4);
+}
+
+void column_handle_test() {
+  Serial.println(F("Column handles test"));
+  CSV_Parser cp("a,b,c,b\n"
+                "1,x,3,4\n"
+                "5,y,7,8\n", /*format*/ "L-ucL");
+
+  CSV_Column c = cp.getColumn("c");
+  assert(c.found() && c.index == 2 && c.type == 'c' && c.is_unsigned);
+  assert(cp.getColumn("b").index == 3); // the first "b" column isn't stored ("-"), so the second one is found
+  assert(!cp.getColumn("d").found() && cp[cp.getColumn("d")] == 0);
+  
+  uint8_t * values = (uint8_t*)cp[c];
+  assert(values == cp["c"] && values[0] == 3 && values[1] == 7);
+}
+
+void skipping_unused_columns_test() {
+  Serial.println(F("Skipping unused columns test"));
+  CSV_Parser cp(/*format*/ "L-s--");
+  // rest of each row is skipped after "c" column, new lines and delimiters within quotes must not end the row
+  cp << "a,b,c,d,e\r\n"
+        "1,x,one,\"2,\r\n\",\"\"\"\r\n"
+        "\"\r\n3,\"\"\"\",three,,\r\n";
+  cp << "4,x,four,,\"\"";
+  cp.parseLeftover();
+
+  int32_t * a = (int32_t*)cp["a"];
+  char   ** c = (char**)cp["c"];
+  assert(cp.getRowsCount() == 3);
+  assert(a[0] == 1 && strcmp(c[0], "one") == 0);
+  assert(a[1] == 3 && strcmp(c[1], "three") == 0);
+  assert(a[2] == 4 && strcmp(c[2], "four") == 0);
+
+  // like when values are parsed, only a quote char at the start of a skipped value starts a quoted value
+  CSV_Parser cp2(/*format*/ "s--", /*has_header*/ false);
+  cp2 << "a,b\"c,\"d\n,\"\n"
+         "b,x\"\r\n"
+         "c,";
+  cp2 << "\"\n\",x\n"
+         "d,e";
+  cp2 << "\"f\n"
+         "e,\"\"\"\"g\",\n";
+  cp2.parseLeftover();
+
+  char ** names = (char**)cp2[0];
+  assert(cp2.getRowsCount() == 5);
+  assert(strcmp(names[0], "a") == 0 && strcmp(names[1], "b") == 0 && strcmp(names[2], "c") == 0);
+  assert(strcmp(names[3], "d") == 0 && strcmp(names[4], "e") == 0);
+}
+
+struct RowCallbackTestData {
+  int rows;
+  int32_t ids_sum;
+  char names[64];
+};
+
+void row_callback_test_on_row(CSV_Row & row, void * user_data) {
+  RowCallbackTestData * data = (RowCallbackTestData*)user_data;
+  assert(row.getIndex() == data->rows);
+  CSV_String name = *(CSV_String*)row["name"];
+  data->ids_sum += *(int32_t*)row[0];
+  strncat(data->names, name.s, name.len);
+  strcat(data->names, "|");
+  data->rows++;
+}
+
+void row_callback_test() {
+  Serial.println(F("Row callback test"));
+  RowCallbackTestData data = {0, 0, ""};
+  CSV_Parser cp(/*format*/ "Ls-");
+  assert(cp.setRowCallback(row_callback_test_on_row, &data));
+  // rows (and values) are split between chunks, escaped quote chars are unescaped
+  cp << "id,name,unused\n1,on" << "e,x\n2,\"t,\"\"w\"\"o\",y\r\n\r" << "\n3,\"thr\nee\"";
+  assert(data.rows == 2);
+  cp << ",\"z";
+  cp.parseLeftover();
+
+  assert(data.rows == 3);
+  assert(data.ids_sum == 6);
+  assert(strcmp(data.names, "one|t,\"w\"o|thr\nee|") == 0);
+  assert(cp.getRowsCount() == 0);
+
+  CSV_Parser cp2(/*format*/ "Ls");
+  assert(cp2.setRowWindow(/*rows*/ 2, /*max_string_len*/ 3));
+  assert(!cp2.setRowCallback(row_callback_test_on_row, &data)); // rows are kept by the window
+}
+
+const char * fill_buffer_test_csv = "a,b\r\n1,\"x\r\ny\"\r\n2,z\n3,w";
+size_t fill_buffer_test_pos = 0;
+
+// supplies 5 chars at a time, so values and rows are split between blocks
+size_t fill_buffer_test_fill(char * buf, size_t capacity) {
+  size_t n = strlen(fill_buffer_test_csv + fill_buffer_test_pos);
+  if (n > 5) n = 5;
+  if (n > capacity) n = capacity;
+  memcpy(buf, fill_buffer_test_csv + fill_buffer_test_pos, n);
+  fill_buffer_test_pos += n;
+  return n;
+}
+
+void fill_buffer_callback_test() {
+  Serial.println(F("Fill buffer callback test"));
+  CSV_Parser cp(/*format*/ "Ls");
+  cp.setFillBufferCallback(fill_buffer_test_fill);
+  int32_t * a = (int32_t*)cp[0];
+  char   ** b = (char**)cp[1];
+
+  const char * expected_b[] = {"x\r\ny", "z", "w"};
+  int rows = 0;
+  while (cp.parseRow()) {
+    assert(cp.getRowsCount() == 1);
+    assert(a[0] == rows + 1);
+    assert(strcmp(b[0], expected_b[rows]) == 0);
+    rows++;
+  }
+  assert(rows == 3);
+}
+
+void row_window_test() {
+  Serial.println(F("Row window test"));
+  CSV_Parser cp(/*format*/ "Ls");
+  assert(cp.setRowWindow(/*rows*/ 2, /*max_string_len*/ 3));
+  assert(!cp.setRowWindow(/*rows*/ 3, /*max_string_len*/ 3)); // already set
+  cp << "id,name\n0,zero\n1,one\n";
+  assert(cp.getRowsCount() == 2 && cp.getDroppedRowsCount() == 0);
+
+  cp << "2,two\n3,\"th\"\"ree\"\n";
+  int32_t * ids = (int32_t*)cp["id"];
+  char ** names = (char**)cp["name"];
+  assert(cp.getRowsCount() == 2);
+  assert(cp.getDroppedRowsCount() == 2);
+  assert(cp.getOldestRowIndex() == 2 && cp.getNewestRowIndex() == 3);
+  assert(cp.getRowPosition(1) == -1 && cp.getRowPosition(4) == -1);
+  assert(ids[cp.getRowPosition(2)] == 2 && strcmp(names[cp.getRowPosition(2)], "two") == 0);
+  assert(ids[cp.getRowPosition(3)] == 3 && strcmp(names[cp.getRowPosition(3)], "th\"") == 0); // truncated
+
+  // kept rows can be read while the next row is only partly supplied (e.g. char by char from serial)
+  cp << "4,fo";
+  assert(cp.getRowsCount() == 2 && cp.getOldestRowIndex() == 2);
+  assert(ids[cp.getRowPosition(2)] == 2 && strcmp(names[cp.getRowPosition(2)], "two") == 0);
+  assert(ids[cp.getRowPosition(3)] == 3 && strcmp(names[cp.getRowPosition(3)], "th\"") == 0);
+  cp << "ur\n";
+  assert(cp.getOldestRowIndex() == 3 && cp.getNewestRowIndex() == 4);
+  assert(ids[cp.getRowPosition(3)] == 3 && strcmp(names[cp.getRowPosition(3)], "th\"") == 0);
+  assert(ids[cp.getRowPosition(4)] == 4 && strcmp(names[cp.getRowPosition(4)], "fou") == 0);
+
+  CSV_Parser cp2(/*format*/ "Ls");
+  assert(cp2.setRowCallback(row_callback_test_on_row));
+  assert(!cp2.setRowWindow(/*rows*/ 2, /*max_string_len*/ 3)); // rows are passed to the callback instead of being kept
+}
+
+const char * row_index_test_csv = "id,name\r\n0,zero\r\n1,\"o\r\nne\"\r\n2,two\n3,three\n4,\"fo\"\"ur\"\n5,five";
+size_t row_index_test_pos = 0;
+
+// supplies 4 chars at a time, so rows are split between blocks (including "\r\n")
+size_t row_index_test_fill(char * buf, size_t capacity) {
+  size_t n = strlen(row_index_test_csv + row_index_test_pos);
+  if (n > 4) n = 4;
+  if (n > capacity) n = capacity;
+  memcpy(buf, row_index_test_csv + row_index_test_pos, n);
+  row_index_test_pos += n;
+  return n;
+}
+
+bool row_index_test_seek(uint32_t position) {
+  row_index_test_pos = position;
+  return position <= strlen(row_index_test_csv);
+}
+
+void row_index_test() {
+  Serial.println(F("Row index test"));
+  CSV_Parser cp(/*format*/ "Ls");
+  cp.setFillBufferCallback(row_index_test_fill);
+  cp.setSeekCallback(row_index_test_seek);
+  assert(cp.buildRowIndex(/*rows_per_entry*/ 4));
+  assert(cp.getIndexedRowsCount() == 6);
+
+  const char * expected_names[] = {"zero", "o\r\nne", "two", "three", "fo\"ur", "five"};
+  for (int start = 0; start < 6; start++) {
+    assert(cp.readRows(start, 2));
+    int32_t * ids = (int32_t*)cp["id"];
+    char ** names = (char**)cp["name"];
+    assert(cp.getRowsCount() == (start < 5 ? 2 : 1));
+    for (int row = 0; row < cp.getRowsCount(); row++) {
+      assert(ids[row] == start + row);
+      assert(strcmp(names[row], expected_names[start + row]) == 0);
+    }
+  }
+  assert(!cp.readRows(6, 1));
+}
+
+void auto_integer_test() {
+  Serial.println(F("Auto integer test"));
+  CSV_Parser cp(/*format*/ "aaaa");
+  cp << "small,signed,wide,mixed\n";
+  cp << "1,1,100,5\n";
+  CSV_Column small = cp.getColumn("small");
+  assert(small.type == 'c' && small.is_unsigned);
+  
+  // supplied by chunks, so columns are widened while earlier rows are already stored
+  cp << "255,-128,70000,-1\n";
+  cp << "0,127,4000000000,300\n";
+  CSV_Column is_signed = cp.getColumn("signed");
+  CSV_Column wide = cp.getColumn("wide");
+  CSV_Column mixed = cp.getColumn("mixed");
+  assert(cp.getColumn("small").type == 'c' && cp.getColumn("small").is_unsigned);
+  assert(is_signed.type == 'c' && !is_signed.is_unsigned);
+  assert(wide.type == 'L' && wide.is_unsigned);
+  assert(mixed.type == 'd' && !mixed.is_unsigned);
+  assert(cp.getConversionErrorsCount() == 0);
+
+  uint8_t * small_values = (uint8_t*)cp[small];
+  int8_t * signed_values = (int8_t*)cp[is_signed];
+  uint32_t * wide_values = (uint32_t*)cp[wide];
+  int16_t * mixed_values = (int16_t*)cp[mixed];
+  assert(small_values[0] == 1 && small_values[1] == 255 && small_values[2] == 0);
+  assert(signed_values[0] == 1 && signed_values[1] == -128 && signed_values[2] == 127);
+  assert(wide_values[0] == 100 && wide_values[1] == 70000 && wide_values[2] == 4000000000UL);
+  assert(mixed_values[0] == 5 && mixed_values[1] == -1 && mixed_values[2] == 300);
+}
+
+void column_aggregate_test() {
+  Serial.println(F("Column aggregate test"));
+  CSV_Parser cp(/*format*/ "sfucL");
+  assert(!cp.setColumnAggregate(0)); // strings can't be aggregated
+  assert(cp.setColumnAggregate(1) && cp.setColumnAggregate(2));
+  cp << "name,temp,";
+  cp << "level,n\nA,1.5,200,1\nB,-2.5,";
+  
+  // statistics are available while parsing (the second row isn't complete yet)
+  CSV_Aggregate temp = cp.getAggregate("temp");
+  assert(temp.count == 2 && temp.min == -2.5 && temp.max == 1.5 && temp.sum == -1.0 && temp.mean == -0.5);
+  assert(temp.variance() == 8.0);
+
+  cp << "255,2\nC,,10,3\n";
+  temp = cp.getAggregate(1);
+  CSV_Aggregate level = cp.getAggregate("level");
+  assert(temp.count == 2); // empty value isn't included
+  assert(level.count == 3 && level.min == 10 && level.max == 255 && level.sum == 465);
+  assert(cp.getAggregate("n").count == 0); // not aggregated
+  
+  // other columns are stored as usual
+  assert(cp.getRowsCount() == 3);
+  assert(strcmp(((char**)cp["name"])[2], "C") == 0 && ((int32_t*)cp["n"])[2] == 3);
+}
+
+void row_filter_test() {
+  Serial.println(F("Row filter test"));
+  CSV_Parser cp(/*format*/ "sLf-");
+  cp << "city,id,temp,note\n";
+  assert(!cp.addFilter("id", CSV_GREATER, "abc")); // not a number
+  assert(cp.addFilter("temp", CSV_GREATER_OR_EQUAL, "20"));
+  assert(cp.addFilter("city", CSV_NOT_EQUAL, "Oslo"));
+  assert(cp.addFilter(3, CSV_NOT_EQUAL, "bad, \"really\"")); // compared with unescaped value
+  cp << "Paris,1,21.5,ok\n\"Oslo\",2,25,ok\nRome,3,,ok\nMadrid,4,";
+  cp << "19.9,\"multi\nline\"\nLisbon,5,30,\"bad, \"\"really\"\"\"\nBerlin,6,20,x\n";
+
+  assert(cp.getRowsCount() == 2);
+  assert(cp.getAcceptedRowsCount() == 2 && cp.getRejectedRowsCount() == 4);
+  char ** cities = (char**)cp["city"];
+  int32_t * ids = (int32_t*)cp["id"];
+  assert(strcmp(cities[0], "Paris") == 0 && ids[0] == 1);
+  assert(strcmp(cities[1], "Berlin") == 0 && ids[1] == 6);
+
+  // values of rejected rows don't overwrite rows kept by the row window
+  CSV_Parser cp2(/*format*/ "Ls");
+  assert(cp2.setRowWindow(/*rows*/ 2, /*max_string_len*/ 5));
+  assert(cp2.addFilter(1, CSV_NOT_EQUAL, "bad"));
+  cp2 << "id,name\n1,one\n2,two\n99,bad\n3,three\n98,bad\n";
+  ids = (int32_t*)cp2["id"];
+  char ** names = (char**)cp2["name"];
+  assert(cp2.getRowsCount() == 2 && cp2.getRejectedRowsCount() == 2);
+  assert(cp2.getOldestRowIndex() == 1 && cp2.getNewestRowIndex() == 2);
+  assert(ids[cp2.getRowPosition(1)] == 2 && strcmp(names[cp2.getRowPosition(1)], "two") == 0);
+  assert(ids[cp2.getRowPosition(2)] == 3 && strcmp(names[cp2.getRowPosition(2)], "three") == 0);
+}
+
+void fixed_point_test() {
+  Serial.println(F("Fixed-point test"));
+  CSV_Parser cp(/*format*/ "q2uq3q0", /*has_header*/ false);
+  cp << "12.34,1.5,7.5\n-0.05,0.0004,-7.5\n 3 ,4294967.295,12\n1.235,.5,x\n";
+  cp << "21474836.48,-1,2.49\n";
+  assert(cp.getRowsCount() == 5);
+
+  int32_t * a = (int32_t*)cp[0];
+  uint32_t * b = (uint32_t*)cp[1];
+  int32_t * c = (int32_t*)cp[2];
+  assert(a[0] == 1234 && a[1] == -5 && a[2] == 300 && a[3] == 124); // decimal places beyond the scale are rounded
+  assert(b[0] == 1500 && b[1] == 0 && b[2] == 4294967295UL && b[3] == 500);
+  assert(c[0] == 8 && c[1] == -8 && c[2] == 12 && c[3] == 0 && c[4] == 2);
+  assert(a[4] == 2147483647 && b[4] == 0); // saturated
+  assert(cp.getConversionErrorsCount() == 3);
+
+  CSV_Column column = cp.getColumn(1);
+  assert(column.type == 'q' && column.is_unsigned && column.scale == 3);
+  assert(strcmp(CSV_ParserT<CSV_Fixed<2>, CSV_UFixed<3>, float>::format(), "q2uq3f") == 0);
+}
+
+struct TestReading {
+  int16_t id;
+  float value;
+  char * name;
+};
+
+void struct_array_test() {
+  Serial.println(F("Struct array test"));
+  TestReading readings[2];
+  CSV_Parser cp(/*format*/ "dfs-L");
+  cp << "id,value,name,note,n\n";
+  assert(!cp.bindColumn("id", offsetof(TestReading, id))); // struct array wasn't set
+  assert(cp.setStructArray(readings, sizeof(TestReading), 2));
+  assert(cp.bindColumn("id", offsetof(TestReading, id)));
+  assert(cp.bindColumn("value", offsetof(TestReading, value)));
+  assert(cp.bindColumn(2, offsetof(TestReading, name)));
+  assert(!cp.bindColumn(3, 0));                          // "-" column
+  assert(!cp.bindColumn("n", sizeof(TestReading) - 2));  // the field doesn't fit in the struct
+  cp << "1,1.5,one,x,10\n2,-2.5,\"t,wo\",y,20\n3,0,three,z,30\n";
+
+  // the 3rd row doesn't fit in the array
+  assert(cp.getRowsCount() == 2 && cp.outOfMemory());
+  assert(cp.getStructArray() == readings);
+  assert(readings[0].id == 1 && readings[0].value == 1.5f && strcmp(readings[0].name, "one") == 0);
+  assert(readings[1].id == 2 && readings[1].value == -2.5f && strcmp(readings[1].name, "t,wo") == 0);
+  assert(((int32_t*)cp["n"])[1] == 20); // not bound column is stored as usual
+
+  // array allocated (and grown) by the parser
+  CSV_Parser cp2(/*format*/ "fd", /*has_header*/ false);
+  assert(cp2.setStructArray(sizeof(TestReading)));
+  assert(cp2.bindColumn(0, offsetof(TestReading, value)) && cp2.bindColumn(1, offsetof(TestReading, id)));
+  for (int i = 0; i < 50; i++) {
+    cp2 << String(i) + ".25," + String(-i) + "\n";
+  }
+  TestReading * structs = (TestReading*)cp2.getStructArray();
+  assert(cp2.getRowsCount() == 50 && !cp2.outOfMemory());
+  assert(structs[49].value == 49.25f && structs[49].id == -49);
 }
 
 void setup() {
@@ -229,6 +637,48 @@ void setup() {
   chunked_supply_test();
   tests_done++;
 
+  reserve_test();
+  tests_done++;
+
+  conversion_errors_test();
+  tests_done++;
+
+  typed_parser_test();
+  tests_done++;
+
+  column_handle_test();
+  tests_done++;
+
+  skipping_unused_columns_test();
+  tests_done++;
+
+  row_callback_test();
+  tests_done++;
+
+  fill_buffer_callback_test();
+  tests_done++;
+
+  row_window_test();
+  tests_done++;
+
+  row_index_test();
+  tests_done++;
+
+  auto_integer_test();
+  tests_done++;
+
+  column_aggregate_test();
+  tests_done++;
+
+  row_filter_test();
+  tests_done++;
+
+  fixed_point_test();
+  tests_done++;
+
+  struct_array_test();
+  tests_done++;
+
   Serial.print(F("Tests done = ")); 
   Serial.println(tests_done, DEC);
 }
@@ -0,0 +1,646 @@
+/*  Benchmarks for: https://github.com/michalmonday/CSV-Parser-for-Arduino
+
+    Build and run with "make benchmark" (from the tests/non_arduino directory).
+    Results are printed as throughput (MB/s) of the whole parsing process.
+*/
+
+#include <CSV_Parser.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+static std::string readWholeFile(const char * f_name) {
+  std::string content;
+  FILE * file = fopen(f_name, "rb");
+  if (!file)
+    return content;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+    content.append(buf, n);
+  fclose(file);
+  return content;
+}
+
+/*  Generates csv with the same layout as file4.csv (12 columns, some of them quoted).  */
+static std::string generateLargeCsv(int rows) {
+  std::string csv = "Index,Customer Id,First Name,Last Name,Company,City,Country,Phone 1,Phone 2,Email,Subscription Date,Website\n";
+  char line[512];
+  for (int i = 1; i <= rows; i++) {
+    snprintf(line, sizeof(line),
+             "%d,%08X%07x,Name%d,Surname%d,\"Company %d, Ltd\",City %d,Country,%d-555-%04d,+1-%d,user%d@example.com,2020-%02d-%02d,http://www.example%d.com/\n",
+             i, i * 2654435761u, i, i, i, i, i % 97, i, i % 10000, i, i, i % 12 + 1, i % 28 + 1, i);
+    csv += line;
+  }
+  return csv;
+}
+
+/*  Generates csv with a few huge quoted fields containing new lines, delimiters and escaped quotes 
+    (each field is field_len bytes long).  */
+static std::string generateQuotedCsv(int rows, int field_len) {
+  std::string csv = "id,notes\n";
+  const char pattern[] = "some notes, \"\"quoted\"\"\nnext line ";
+  for (int i = 1; i <= rows; i++) {
+    csv += std::to_string(i) + ",\"";
+    for (int len = 0; len < field_len; len += sizeof(pattern) - 1)
+      csv += pattern;
+    csv += "\"\n";
+  }
+  return csv;
+}
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void printResult(const char * name, size_t bytes, double seconds, int rows) {
+  printf("  %-40s %10.2f MB/s  (%d rows, %.3f s)\n", name, bytes / seconds / 1e6, rows, seconds);
+}
+
+/*  Supplies csv to the parser by chunks of chunk_size bytes (chunk_size == 1 uses "cp << char").  */
+static void benchmarkChunkedSupply(const char * name, const std::string & csv, const char * fmt, size_t chunk_size, int repeats) {
+  char * chunk = (char*)malloc(chunk_size + 1);
+  int rows = 0;
+  Clock::time_point start = Clock::now();
+  for (int r = 0; r < repeats; r++) {
+    CSV_Parser cp(fmt);
+    if (chunk_size == 1) {
+      for (size_t i = 0; i < csv.size(); i++)
+        cp << csv[i];
+    } else {
+      for (size_t i = 0; i < csv.size(); i += chunk_size) {
+        size_t n = csv.size() - i < chunk_size ? csv.size() - i : chunk_size;
+        memcpy(chunk, csv.data() + i, n);
+        chunk[n] = 0;
+        cp << chunk;
+      }
+    }
+    cp.parseLeftover();
+    rows = cp.getRowsCount();
+  }
+  double seconds = secondsSince(start);
+  free(chunk);
+
+  char label[128];
+  snprintf(label, sizeof(label), "%s, %zu-byte chunks", name, chunk_size);
+  printResult(label, csv.size() * repeats, seconds, rows);
+}
+
+/*  Parses csv supplied as a single string. With "fmt" consisting of '-' only, only the first value of each row 
+    is parsed and the rest of the row is skipped.  */
+static void benchmarkWholeBuffer(const char * name, const std::string & csv, const char * fmt, int repeats) {
+  int rows = 0;
+  Clock::time_point start = Clock::now();
+  for (int r = 0; r < repeats; r++) {
+    CSV_Parser cp(csv.c_str(), fmt);
+    rows = cp.getRowsCount();
+  }
+  char label[128];
+  snprintf(label, sizeof(label), "%s, \"%s\"", name, fmt);
+  printResult(label, csv.size() * repeats, secondsSince(start), rows);
+}
+
+/*  Compares numeric conversion of the parser with libc functions (copying each value into 0-terminated buffer 
+    and converting it, like the parser used to do). Time of the parser with "-" format (tokenizing only) is 
+    subtracted from the time of the parser with "fmt" format, so only the conversion time is compared.  */
+static void benchmarkNumericConversion(const char * fmt, int values_count) {
+  char type = strchr(fmt, 'q') ? 'f' : fmt[strlen(fmt) - 1]; // fixed-point values are compared with atof
+  std::string csv;
+  char num[32];
+  srand(1);
+  for (int i = 0; i < values_count; i++) {
+    switch (type) {
+      case 'f': snprintf(num, sizeof(num), "%.3f\n", (rand() - RAND_MAX / 2) / 997.0); break;
+      case 'x': snprintf(num, sizeof(num), "%X\n", rand()); break;
+      case 'd': snprintf(num, sizeof(num), "%d\n", rand() % 65536 - 32768); break;
+      default:  snprintf(num, sizeof(num), "%d\n", rand() - RAND_MAX / 2); break;
+    }
+    csv += num;
+  }
+
+  // the best of 3 runs is taken
+  double libc_seconds = 1e9, parser_seconds = 1e9;
+  for (int run = 0; run < 3; run++) {
+    Clock::time_point start = Clock::now();
+    volatile double sink = 0;
+    const char * p = csv.c_str();
+    const char * end = p + csv.size();
+    char buf[32];
+    while (p < end) {
+      const char * nl = (const char*)memchr(p, '\n', end - p);
+      memcpy(buf, p, nl - p);
+      buf[nl - p] = 0;
+      switch (type) {
+        case 'f': sink = sink + atof(buf); break;
+        case 'x': sink = sink + strtol(buf, 0, 16); break;
+        case 'd': sink = sink + (int16_t)atoi(buf); break;
+        default:  sink = sink + (fmt[0] == 'u' ? strtoul(buf, 0, 10) : atol(buf)); break;
+      }
+      p = nl + 1;
+    }
+    libc_seconds = std::min(libc_seconds, secondsSince(start));
+
+    start = Clock::now();
+    { CSV_Parser cp(csv.c_str(), "-", false); }
+    double tokenizing_seconds = secondsSince(start);
+    start = Clock::now();
+    { CSV_Parser cp(csv.c_str(), fmt, false); }
+    parser_seconds = std::min(parser_seconds, secondsSince(start) - tokenizing_seconds);
+  }
+
+  printf("  \"%s\": libc %6.2f ns/value, CSV_Parser %6.2f ns/value\n", fmt, 
+         libc_seconds * 1e9 / values_count, parser_seconds * 1e9 / values_count);
+}
+
+/*  Compares auto integer columns ("a") with 32-bit columns ("L") on sensor-like data (values of each column fit 
+    different types), printing parsing speed and memory used by values.  */
+static void benchmarkAutoIntegers(int rows, int repeats) {
+  std::string csv = "id,temperature,humidity,pressure\n";
+  char line[64];
+  srand(1);
+  for (int i = 0; i < rows; i++) {
+    snprintf(line, sizeof(line), "%d,%d,%d,%d\n", i, rand() % 125 - 40, rand() % 101, 9000 + rand() % 2000);
+    csv += line;
+  }
+  const char * formats[] = {"LLLL", "aaaa"};
+  for (const char * fmt : formats) {
+    size_t bytes = 0;
+    int rows_count = 0;
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < repeats; r++) {
+      CSV_Parser cp(csv.c_str(), fmt);
+      cp.shrinkToFit();
+      rows_count = cp.getRowsCount();
+      bytes = 0;
+      for (int col = 0; col < cp.getColumnsCount(); col++) {
+        char type = cp.getColumn(col).type;
+        bytes += (size_t)rows_count * (type == 'c' ? 1 : type == 'd' ? 2 : 4);
+      }
+    }
+    char label[128];
+    snprintf(label, sizeof(label), "\"%s\", %zu bytes of values", fmt, bytes);
+    printResult(label, csv.size() * repeats, secondsSince(start), rows_count);
+  }
+}
+
+/*  Compares storing all rows with keeping rows that match a filter (rejected rows are skipped once the filtered value is found, 
+    so the filter on the first column skips almost whole rows and the filter near the end stores most values of rows first).  */
+static void benchmarkRowFilter(const std::string & csv, const char * fmt, int repeats) {
+  struct { const char * label; int col; CSV_FilterOp op; const char * value; } filters[] = {
+    {"no filter", -1, CSV_EQUAL, 0},
+    {"filter on the first column (10% kept)", 0, CSV_LESS_OR_EQUAL, "5000"},
+    {"filter on the 11th column (8% kept)", 10, CSV_LESS, "2020-02"},
+  };
+  for (auto & filter : filters) {
+    int rows = 0;
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < repeats; r++) {
+      CSV_Parser cp(fmt);
+      if (filter.value)
+        cp.addFilter(filter.col, filter.op, filter.value);
+      cp << csv.c_str();
+      cp.parseLeftover();
+      rows = cp.getRowsCount();
+    }
+    printResult(filter.label, csv.size() * repeats, secondsSince(start), rows);
+  }
+}
+
+/*  Compares parsing into values arrays followed by copying rows into an array of structs (what the user had to do before) 
+    with parsing directly into the array of structs.  */
+static void benchmarkStructArray(const std::string & csv, int repeats) {
+  struct Customer { int32_t index; char * company; char * email; };
+  const char * fmt = "L---s----s--";
+  for (int direct = 0; direct < 2; direct++) {
+    int rows = 0;
+    volatile int32_t sink = 0;
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < repeats; r++) {
+      CSV_Parser cp(fmt);
+      Customer * customers;
+      if (direct) {
+        cp.setStructArray(sizeof(Customer));
+        cp.bindColumn(0, offsetof(Customer, index));
+        cp.bindColumn(4, offsetof(Customer, company));
+        cp.bindColumn(9, offsetof(Customer, email));
+        cp << csv.c_str();
+        cp.parseLeftover();
+        rows = cp.getRowsCount();
+        customers = (Customer*)cp.getStructArray();
+      } else {
+        cp << csv.c_str();
+        cp.parseLeftover();
+        rows = cp.getRowsCount();
+        customers = (Customer*)malloc(rows * sizeof(Customer));
+        for (int i = 0; i < rows; i++) {
+          customers[i].index = ((int32_t*)cp[0])[i];
+          customers[i].company = ((char**)cp[4])[i];
+          customers[i].email = ((char**)cp[9])[i];
+        }
+      }
+      for (int i = 0; i < rows; i++)
+        sink = sink + customers[i].index;
+      if (!direct)
+        free(customers);
+    }
+    printResult(direct ? "parsed into array of structs" : "values arrays + copying into structs", csv.size() * repeats, secondsSince(start), rows);
+  }
+}
+
+/*  Compares looking up columns of a wide csv by name: linear search (how cp["key"] used to work), 
+    hashed search (cp["key"]) and column handles resolved once (cp[column]).  */
+static void benchmarkColumnLookup(int cols, int rows) {
+  std::string csv, fmt;
+  std::vector<std::string> keys;
+  for (int col = 0; col < cols; col++) {
+    keys.push_back("column_name_" + std::to_string(col));
+    csv += (col ? "," : "") + keys.back();
+    fmt += "L";
+  }
+  csv += "\n";
+  for (int row = 0; row < rows; row++)
+    for (int col = 0; col < cols; col++)
+      csv += std::to_string(row * cols + col) + (col == cols - 1 ? "\n" : ",");
+  CSV_Parser cp(csv.c_str(), fmt.c_str());
+
+  // every row, every column looked up by name (like inside a loop over rows)
+  const int lookups = rows * cols;
+  volatile int64_t sum = 0;
+  Clock::time_point start = Clock::now();
+  for (int row = 0; row < rows; row++)
+    for (int col = 0; col < cols; col++) {
+      const char * key = keys[col].c_str();
+      for (int i = 0; i < cols; i++)
+        if (keys[i] == key) {
+          sum = sum + ((int32_t*)cp[i])[row];
+          break;
+        }
+    }
+  double linear_seconds = secondsSince(start);
+
+  start = Clock::now();
+  for (int row = 0; row < rows; row++)
+    for (int col = 0; col < cols; col++)
+      sum = sum + ((int32_t*)cp[keys[col].c_str()])[row];
+  double hashed_seconds = secondsSince(start);
+
+  start = Clock::now();
+  std::vector<CSV_Column> columns;
+  for (int col = 0; col < cols; col++)
+    columns.push_back(cp.getColumn(keys[col].c_str()));
+  for (int row = 0; row < rows; row++)
+    for (int col = 0; col < cols; col++)
+      sum = sum + ((int32_t*)cp[columns[col]])[row];
+  double handle_seconds = secondsSince(start);
+
+  printf("  %d columns, %d lookups: linear %6.2f ns/lookup, hashed %6.2f ns/lookup, handles %6.2f ns/access\n", cols, lookups,
+         linear_seconds * 1e9 / lookups, hashed_seconds * 1e9 / lookups, handle_seconds * 1e9 / lookups);
+}
+
+static void countRow(CSV_Row & row, void * user_data) {
+  (*(int*)user_data)++;
+}
+
+/*  Compares storing all rows with passing them to the row callback (csv supplied by 4096-byte chunks). 
+    Memory used by the parser is measured with a memory pool (high water mark).  */
+static void benchmarkRowCallback(const std::string & csv, const char * fmt, int repeats) {
+  const size_t chunk_size = 4096;
+  static char pool[64 << 20];
+  for (int use_callback = 0; use_callback < 2; use_callback++) {
+    int rows = 0;
+    size_t memory = 0;
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < repeats; r++) {
+      CSV_Parser cp(pool, sizeof(pool), fmt);
+      int visited = 0;
+      if (use_callback)
+        cp.setRowCallback(countRow, &visited);
+      char chunk[chunk_size + 1];
+      for (size_t i = 0; i < csv.size(); i += chunk_size) {
+        size_t n = csv.size() - i < chunk_size ? csv.size() - i : chunk_size;
+        memcpy(chunk, csv.data() + i, n);
+        chunk[n] = 0;
+        cp << chunk;
+      }
+      cp.parseLeftover();
+      rows = use_callback ? visited : cp.getRowsCount();
+      memory = cp.highWaterMark();
+    }
+    char label[128];
+    snprintf(label, sizeof(label), "%s (%zu KB of memory)", use_callback ? "row callback" : "storing rows", memory >> 10);
+    printResult(label, csv.size() * repeats, secondsSince(start), rows);
+  }
+}
+
+/*  Input of parseRow: the whole csv is in memory, so only the cost of supplying it to the parser is measured.  */
+static const std::string * row_parser_csv;
+static size_t row_parser_pos;
+
+static char feedOneChar() { return row_parser_pos < row_parser_csv->size() ? (*row_parser_csv)[row_parser_pos++] : 0; }
+static char * feedNoString() { return 0; }
+static bool allCharsFed() { return row_parser_pos >= row_parser_csv->size(); }
+
+static size_t fillBlock(char * buf, size_t capacity) {
+  size_t n = std::min(capacity, row_parser_csv->size() - row_parser_pos);
+  memcpy(buf, row_parser_csv->data() + row_parser_pos, n);
+  row_parser_pos += n;
+  return n;
+}
+
+/*  Compares parseRow supplied by single chars (feedRowParser/rowParserFinished callbacks) with parseRow supplied 
+    by blocks (fill buffer callback).  */
+static void benchmarkParseRow(const char * name, const std::string & csv, const char * fmt, int repeats) {
+  row_parser_csv = &csv;
+  for (int use_fill = 0; use_fill < 2; use_fill++) {
+    int rows = 0;
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < repeats; r++) {
+      row_parser_pos = 0;
+      CSV_Parser cp(fmt);
+      if (use_fill) {
+        cp.setFillBufferCallback(fillBlock);
+      } else {
+        cp.setFeedRowParserCallback(feedOneChar);
+        cp.setFeedRowParserStrCallback(feedNoString);
+        cp.setRowParserFinishedCallback(allCharsFed);
+      }
+      rows = 0;
+      while (cp.parseRow())
+        rows++;
+    }
+    char label[128];
+    snprintf(label, sizeof(label), "%s, %s", name, use_fill ? "fill buffer callback" : "feedRowParser");
+    printResult(label, csv.size() * repeats, secondsSince(start), rows);
+  }
+}
+
+/*  Parses the whole string with parseParallel using 1, 2, 4, ... threads (up to max_threads).  */
+static void benchmarkParallel(const std::string & csv, const char * fmt, int max_threads, int repeats) {
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    int rows = 0;
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < repeats; r++) {
+      CSV_Parser cp(fmt);
+      cp.parseParallel(csv.c_str(), threads);
+      rows = cp.getRowsCount();
+    }
+    char label[128];
+    snprintf(label, sizeof(label), "\"%s\", %d threads", fmt, threads);
+    printResult(label, csv.size() * repeats, secondsSince(start), rows);
+  }
+}
+
+/*  Each thread parses its own copy of csv with its own parser (supplied by 4096-byte chunks, like streams
+    read by separate tasks), total throughput of 1, 2, 4, ... threads (up to max_threads) is printed.  */
+static void benchmarkIndependentParsers(const std::string & csv, const char * fmt, int max_threads, int repeats) {
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    std::vector<int> rows(threads);
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+      workers.emplace_back([&csv, fmt, repeats, &rows, t]() {
+        char chunk[4097];
+        for (int r = 0; r < repeats; r++) {
+          CSV_Parser cp(fmt);
+          for (size_t i = 0; i < csv.size(); i += 4096) {
+            size_t n = std::min(csv.size() - i, (size_t)4096);
+            memcpy(chunk, csv.data() + i, n);
+            chunk[n] = 0;
+            cp << chunk;
+          }
+          cp.parseLeftover();
+          rows[t] = cp.getRowsCount();
+        }
+      });
+    }
+    for (std::thread & worker : workers)
+      worker.join();
+    char label[128];
+    snprintf(label, sizeof(label), "\"%s\", %d parsers", fmt, threads);
+    printResult(label, csv.size() * repeats * threads, secondsSince(start), rows[0]);
+  }
+}
+
+/*  Compares reading the file char by char with fgetc (how it used to be done) with block-based readFile.  */
+static void benchmarkFileReading(const char * f_name, const char * fmt, int repeats) {
+  size_t bytes = readWholeFile(f_name).size() * repeats;
+  int rows = 0;
+  Clock::time_point start = Clock::now();
+  for (int r = 0; r < repeats; r++) {
+    CSV_Parser cp(fmt);
+    FILE * file = fopen(f_name, "r");
+    int c;
+    while ((c = fgetc(file)) != EOF)
+      cp << (char)c;
+    fclose(file);
+    cp.parseLeftover();
+    rows = cp.getRowsCount();
+  }
+  printResult("fgetc + cp << char", bytes, secondsSince(start), rows);
+
+  start = Clock::now();
+  for (int r = 0; r < repeats; r++) {
+    CSV_Parser cp(fmt);
+    cp.readFile(f_name);
+    rows = cp.getRowsCount();
+  }
+  printResult("readFile", bytes, secondsSince(start), rows);
+}
+
+/*  Compares readFile (strings are copied) with mapFile (strings point into the mapped file). 
+    Memory used by the parser is measured with a memory pool (high water mark), the mapping itself isn't included. 
+    Rows are reserved up front, so memory given back to the pool by growing arrays doesn't distort the comparison.  */
+static void benchmarkMappedFile(const char * f_name, const char * fmt, int repeats) {
+  std::string content = readWholeFile(f_name);
+  size_t bytes = content.size() * repeats;
+  int lines = std::count(content.begin(), content.end(), '\n');
+  static char pool[64 << 20];
+  for (int use_mapping = 0; use_mapping < 2; use_mapping++) {
+    int rows = 0;
+    size_t memory = 0;
+    Clock::time_point start = Clock::now();
+    for (int r = 0; r < repeats; r++) {
+      CSV_Parser cp(pool, sizeof(pool), fmt);
+      cp.reserve(lines);
+      if (use_mapping)
+        cp.mapFile(f_name);
+      else
+        cp.readFile(f_name);
+      rows = cp.getRowsCount();
+      memory = cp.highWaterMark();
+    }
+    char label[128];
+    snprintf(label, sizeof(label), "\"%s\", %s (%zu KB of memory)", fmt, use_mapping ? "mapFile" : "readFile", memory >> 10);
+    printResult(label, bytes, secondsSince(start), rows);
+  }
+}
+
+/*  Compares parsing the file with loading values from a snapshot saved after parsing it.  */
+static void benchmarkSnapshot(const char * f_name, const char * fmt, int repeats) {
+  const char * snapshot_f_name = "benchmark_synthetic.snapshot";
+  CSV_Parser parsed(fmt);
+  parsed.readFile(f_name);
+  parsed.saveSnapshot(snapshot_f_name);
+  size_t snapshot_size = readWholeFile(snapshot_f_name).size();
+
+  int rows = 0;
+  Clock::time_point start = Clock::now();
+  for (int r = 0; r < repeats; r++) {
+    CSV_Parser cp(fmt);
+    cp.readFile(f_name);
+    rows = cp.getRowsCount();
+  }
+  double parse_seconds = secondsSince(start);
+
+  start = Clock::now();
+  for (int r = 0; r < repeats; r++) {
+    CSV_Parser cp(fmt);
+    cp.loadSnapshot(snapshot_f_name);
+    rows = cp.getRowsCount();
+  }
+  double load_seconds = secondsSince(start);
+  remove(snapshot_f_name);
+
+  size_t bytes = readWholeFile(f_name).size();
+  printf("  \"%s\": readFile %.2f ms, loadSnapshot %.2f ms (%d rows, csv %zu KB, snapshot %zu KB)\n", fmt, 
+         parse_seconds * 1e3 / repeats, load_seconds * 1e3 / repeats, rows, bytes >> 10, snapshot_size >> 10);
+}
+
+/*  Input of buildRowIndex/readRows (file descriptor of the indexed file).  */
+static int indexed_fd;
+
+static size_t readIndexedFile(char * buf, size_t capacity) {
+  ssize_t n = read(indexed_fd, buf, capacity);
+  return n > 0 ? n : 0;
+}
+
+static bool seekIndexedFile(uint32_t position) {
+  return lseek(indexed_fd, position, SEEK_SET) == (off_t)position;
+}
+
+/*  Compares looking up a single row by parsing the file row by row until the row is reached with readRows using the row index.  */
+static void benchmarkRowIndex(const char * f_name, const char * fmt, uint32_t row, int rows_per_entry, int repeats) {
+  indexed_fd = open(f_name, O_RDONLY);
+  CSV_Parser cp(fmt);
+  cp.setFillBufferCallback(readIndexedFile);
+  cp.setSeekCallback(seekIndexedFile);
+
+  Clock::time_point start = Clock::now();
+  cp.buildRowIndex(rows_per_entry);
+  double build_seconds = secondsSince(start);
+
+  start = Clock::now();
+  for (int r = 0; r < repeats; r++) {
+    CSV_Parser row_parser(fmt);
+    row_parser.setFillBufferCallback(readIndexedFile);
+    seekIndexedFile(0);
+    for (uint32_t i = 0; i <= row && row_parser.parseRow(); i++)
+      ;
+  }
+  double scan_seconds = secondsSince(start);
+
+  start = Clock::now();
+  for (int r = 0; r < repeats; r++)
+    cp.readRows(row, 1);
+  double lookup_seconds = secondsSince(start);
+  close(indexed_fd);
+
+  printf("  row %u: parseRow until the row %.3f ms, readRows %.3f ms (index of %u rows, every %d-th, built in %.2f ms)\n", row,
+         scan_seconds * 1e3 / repeats, lookup_seconds * 1e3 / repeats, cp.getIndexedRowsCount(), rows_per_entry, build_seconds * 1e3);
+}
+
+int main() {
+  std::string file4 = readWholeFile("file4.csv");
+  if (file4.empty()) {
+    printf("Error: file4.csv not found\n");
+    return 1;
+  }
+  std::string large = generateLargeCsv(50000);
+  const size_t chunk_sizes[] = {1, 64, 4096};
+
+  printf("Chunked supply (supplyChunk / leftover buffer):\n");
+  for (size_t chunk_size : chunk_sizes)
+    benchmarkChunkedSupply("file4.csv", file4, "Ls-------s--", chunk_size, 200);
+  for (size_t chunk_size : chunk_sizes)
+    benchmarkChunkedSupply("synthetic", large, "Ls-------s--", chunk_size, 1);
+
+#if defined(CSV_PARSER_SIMD)
+  printf("Whole buffer (SIMD scanning):\n");
+#else
+  printf("Whole buffer (scalar scanning):\n");
+#endif
+  benchmarkWholeBuffer("synthetic", large, "------------", 20);
+  benchmarkWholeBuffer("synthetic", large, "Ls-------s--", 20);
+
+  printf("Huge quoted fields (time should grow linearly with field length):\n");
+  for (int field_len = 1 << 16; field_len <= 1 << 18; field_len <<= 1) {
+    std::string quoted = generateQuotedCsv(4, field_len);
+    char name[64];
+    snprintf(name, sizeof(name), "%d KB fields", field_len >> 10);
+    benchmarkChunkedSupply(name, quoted, "Ls", 1, 1);
+    benchmarkChunkedSupply(name, quoted, "Ls", 64, 1);
+  }
+
+  printf("Numeric conversion:\n");
+  const char * numeric_formats[] = {"L", "uL", "d", "x", "f", "q3"};
+  for (const char * fmt : numeric_formats)
+    benchmarkNumericConversion(fmt, 1000000);
+
+  printf("Auto integer columns (synthetic sensor data):\n");
+  benchmarkAutoIntegers(100000, 10);
+
+  printf("Row filters (synthetic, \"Lsssssssssss\"):\n");
+  benchmarkRowFilter(large, "Lsssssssssss", 5);
+
+  printf("Array of structs (synthetic):\n");
+  benchmarkStructArray(large, 10);
+
+  printf("Column lookup by name:\n");
+  benchmarkColumnLookup(10, 20000);
+  benchmarkColumnLookup(60, 5000);
+
+  printf("parseRow (data of parsing_row_by_row examples):\n");
+  std::string row_by_row_csv = "my_strings,my_numbers\r\nhello,5\r\nworld,10\r\n";
+  benchmarkParseRow("parsing_row_by_row", row_by_row_csv, "sL", 100000);
+  benchmarkParseRow("file4.csv", file4, "Ls-------s--", 200);
+
+  printf("Row callback vs storing rows (synthetic, \"Ls-------s--\"):\n");
+  benchmarkRowCallback(large, "Ls-------s--", 5);
+
+  printf("Parallel parsing (synthetic, %u CPU cores available):\n", std::thread::hardware_concurrency());
+  std::string huge = generateLargeCsv(400000);
+  benchmarkParallel(huge, "Ls-------s--", 16, 3);
+  benchmarkParallel(huge, "Lsssssssssss", 16, 3);
+
+  printf("Independent parsers in separate threads (synthetic):\n");
+  benchmarkIndependentParsers(large, "Ls-------s--", 16, 5);
+
+  const char * large_f_name = "benchmark_synthetic.csv";
+  FILE * large_file = fopen(large_f_name, "wb");
+  fwrite(large.data(), 1, large.size(), large_file);
+  fclose(large_file);
+
+  printf("File reading (synthetic file):\n");
+  benchmarkFileReading(large_f_name, "Ls-------s--", 3);
+  benchmarkMappedFile(large_f_name, "Ls-------s--", 3);
+  benchmarkMappedFile(large_f_name, "Lsssssssssss", 3);
+
+  printf("Snapshot (synthetic file):\n");
+  benchmarkSnapshot(large_f_name, "Ls-------s--", 10);
+  benchmarkSnapshot(large_f_name, "Lsssssssssss", 10);
+
+  printf("Row index (synthetic file):\n");
+  benchmarkRowIndex(large_f_name, "Ls-------s--", 40000, 64, 20);
+  remove(large_f_name);
+  return 0;
+}
@@ -1,6 +1,11 @@
 
 #include <CSV_Parser.h>
 #include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
 const char * csv_str = "my_strings,my_ints\n"
                        "hello,1\n"
@@ -8,20 +13,218 @@ const char * csv_str = "my_strings,my_ints\n"
                        "noice,3\n"
                        "hehe,4\n";
 
+/*  Parses the csv by chunks of chunk_size chars (so "\r\n" and quotes are often split between chunks) and checks 
+    that the values are the same as the expected ones. The typed front-end is used, so its format string is also 
+    obtained by multiple threads at once.  */
+static void parseInChunks(const char * csv, size_t chunk_size, CSV_Parser * expected, bool * ok) {
+    for (int repeat = 0; repeat < 50 && *ok; repeat++) {
+        CSV_ParserT<int32_t, char*> cp; // same as CSV_Parser cp("Ls")
+        char chunk[16];
+        size_t len = strlen(csv);
+        for (size_t i = 0; i < len; i += chunk_size) {
+            size_t n = len - i < chunk_size ? len - i : chunk_size;
+            memcpy(chunk, csv + i, n);
+            chunk[n] = 0;
+            cp << chunk;
+        }
+        cp.parseLeftover();
+        *ok = cp.getRowsCount() == expected->getRowsCount();
+        for (int row = 0; *ok && row < cp.getRowsCount(); row++)
+            *ok = ((int32_t*)cp[0])[row] == ((int32_t*)(*expected)[0])[row] && 
+                  strcmp(((char**)cp[1])[row], ((char**)(*expected)[1])[row]) == 0;
+    }
+}
+
+/*  Generates csv of at least min_len chars with CRLF and LF new lines, quoted values containing new lines and escaped 
+    quote chars, rows with fewer values than columns (they're joined with the next row) and an auto integer column whose 
+    values get wider in the second half (so chunks are split inside quoted values and auto columns must be widened).  */
+static std::string generateParallelCsv(size_t min_len) {
+    std::string csv = "id,text,number,unused,last\r\n";
+    char row[128];
+    for (int i = 0; csv.size() < min_len; i++) {
+        long number = csv.size() < min_len / 2 ? i % 100 : -1000L * i;
+        if (i % 7 == 3)
+            snprintf(row, sizeof(row), "%d,\"multi\r\nline, \"\"%d\"\"\n\",%ld,x,\"a\nb\"\r\n", i, i, number);
+        else if (i % 11 == 5)
+            snprintf(row, sizeof(row), "%d,short\n", i);
+        else
+            snprintf(row, sizeof(row), "%d,plain %d,%ld,,last\n", i, i, number);
+        csv += row;
+    }
+    return csv;
+}
+
+static bool sameStrings(const char * a, const char * b) { return a == b || (a && b && strcmp(a, b) == 0); }
+
+/*  Compares values parsed by parseParallel with values of the same csv parsed sequentially.  */
+static bool parseParallelMatches(const std::string & csv, int threads) {
+    const char * format = "Lsa-s";
+    CSV_Parser expected(/*format*/ format);
+    expected << csv.c_str();
+    expected.parseLeftover();
+    CSV_Parser cp(/*format*/ format);
+    if (!cp.parseParallel(csv.c_str(), threads) || cp.getRowsCount() != expected.getRowsCount() || !expected.getRowsCount())
+        return false;
+    CSV_Column number = cp.getColumn(2), expected_number = expected.getColumn(2);
+    if (number.type != expected_number.type || number.is_unsigned != expected_number.is_unsigned)
+        return false;
+    size_t number_size = number.type == 'L' ? 4 : number.type == 'd' ? 2 : 1;
+    if (memcmp(cp[2], expected[2], expected.getRowsCount() * number_size) != 0)
+        return false;
+    for (int row = 0; row < cp.getRowsCount(); row++) {
+        if (((int32_t*)cp[0])[row] != ((int32_t*)expected[0])[row] || 
+            !sameStrings(((char**)cp[1])[row], ((char**)expected[1])[row]) || 
+            !sameStrings(((char**)cp[4])[row], ((char**)expected[4])[row]))
+            return false;
+    }
+    return true;
+}
+
 int main() {
     CSV_Parser cp(/*format*/ "Ls-------s--");
     // read csv file 
-    FILE * file = fopen("file4.csv", "r");
-    if (file == NULL) {
+    if (!cp.readFile("file4.csv")) {
         printf("Error: file not found\n");
         return 1;
     }
-    char c = fgetc(file);
-    while (c != EOF) {
-        cp << c;
-        c = fgetc(file);
-    }
-    cp.parseLeftover();
     cp.print();
+
+#ifdef CSV_PARSER_ENABLE_STATS
+    // built with "make stats"
+    CSV_Stats stats = cp.getStats();
+    FILE * file = fopen("file4.csv", "rb");
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fclose(file);
+    printf("Stats: %u bytes, %u rows, %u values, %u allocs, %u reallocs, %u frees, memory used %zu (peak %zu), "
+           "tokenize %u us, convert %u us, store %u us\n", stats.bytes_parsed, stats.rows_parsed, stats.values_parsed, 
+           stats.allocs, stats.reallocs, stats.frees, stats.memory_used, stats.memory_peak, 
+           stats.tokenize_us, stats.convert_us, stats.store_us);
+    if (stats.bytes_parsed != (uint32_t)file_size || stats.rows_parsed != (uint32_t)cp.getRowsCount() || 
+        stats.values_parsed != 10 * (stats.rows_parsed + 1) /* last 2 values of rows (and header) are skipped */ || !stats.memory_used || stats.memory_peak < stats.memory_used) {
+        printf("Error: wrong stats\n");
+        return 1;
+    }
+#endif
+
+    // the same file parsed by multiple threads must give the same values
+    CSV_Parser cp_parallel(/*format*/ "Ls-------s--");
+    if (!cp_parallel.readFileParallel("file4.csv", 4) || cp_parallel.getRowsCount() != cp.getRowsCount()) {
+        printf("Error: parallel parsing failed\n");
+        return 1;
+    }
+    for (int row = 0; row < cp.getRowsCount(); row++) {
+        if (((int32_t*)cp_parallel[0])[row] != ((int32_t*)cp[0])[row] || 
+            strcmp(((char**)cp_parallel[9])[row], ((char**)cp[9])[row]) != 0) {
+            printf("Error: parallel parsing gave different values (row %d)\n", row);
+            return 1;
+        }
+    }
+
+    // csv large enough to be split into chunks (built with "make parallel" the chunks are much smaller, so there are many 
+    // more splits, landing inside quoted values and joined rows)
+    std::string parallel_csv = generateParallelCsv(4 * CSV_PARSER_PARALLEL_MIN_CHUNK_SIZE + 1000);
+    for (int threads = 2; threads <= 8; threads++) {
+        if (!parseParallelMatches(parallel_csv, threads)) {
+            printf("Error: parallel parsing of generated csv gave different values (%d threads)\n", threads);
+            return 1;
+        }
+    }
+
+    // mapped file gives the same values, strings are (pointer, length) views into the file
+    CSV_Parser cp_mapped(/*format*/ "Ls-------s--");
+    if (!cp_mapped.mapFile("file4.csv") || cp_mapped.getRowsCount() != cp.getRowsCount()) {
+        printf("Error: mapping the file failed\n");
+        return 1;
+    }
+    for (int row = 0; row < cp.getRowsCount(); row++) {
+        CSV_String email = ((CSV_String*)cp_mapped[9])[row];
+        if (((int32_t*)cp_mapped[0])[row] != ((int32_t*)cp[0])[row] || 
+            email.len != (int)strlen(((char**)cp[9])[row]) || memcmp(email.s, ((char**)cp[9])[row], email.len) != 0) {
+            printf("Error: mapped file gave different values (row %d)\n", row);
+            return 1;
+        }
+    }
+
+    // values restored from the snapshot are the same as parsed ones
+    if (!cp.saveSnapshot("file4.snapshot")) {
+        printf("Error: saving the snapshot failed\n");
+        return 1;
+    }
+    CSV_Parser cp_snapshot(/*format*/ "Ls-------s--");
+    bool loaded = cp_snapshot.loadSnapshot("file4.snapshot");
+    remove("file4.snapshot");
+    if (!loaded || cp_snapshot.getRowsCount() != cp.getRowsCount() || !cp_snapshot.getColumn("Email").found()) {
+        printf("Error: loading the snapshot failed\n");
+        return 1;
+    }
+    for (int row = 0; row < cp.getRowsCount(); row++) {
+        if (((int32_t*)cp_snapshot["Index"])[row] != ((int32_t*)cp[0])[row] || 
+            strcmp(((char**)cp_snapshot["Email"])[row], ((char**)cp[9])[row]) != 0) {
+            printf("Error: snapshot gave different values (row %d)\n", row);
+            return 1;
+        }
+    }
+
+    // loading a damaged snapshot leaves the parser unchanged (auto integer column isn't left widened to the saved type)
+    CSV_Parser cp_auto(/*format*/ "aL");
+    cp_auto << "big,n\n100000,1\n";
+    FILE * auto_file = cp_auto.saveSnapshot("auto.snapshot") ? fopen("auto.snapshot", "rb") : 0;
+    long auto_size = auto_file && fseek(auto_file, 0, SEEK_END) == 0 ? ftell(auto_file) : 0;
+    if (auto_file)
+        fclose(auto_file);
+    // the last value is cut off (the auto column preceding it was already widened when reading fails)
+    if (auto_size < 2 || truncate("auto.snapshot", auto_size - 2) != 0) {
+        printf("Error: saving the snapshot failed\n");
+        return 1;
+    }
+    CSV_Parser cp_damaged(/*format*/ "aL");
+    loaded = cp_damaged.loadSnapshot("auto.snapshot");
+    remove("auto.snapshot");
+    cp_damaged << "big,n\n5,1\n";
+    if (loaded || cp_damaged.getRowsCount() != 1 || cp_damaged.getColumn(0).type != 'c' || ((uint8_t*)cp_damaged[0])[0] != 5) {
+        printf("Error: failed loading of the snapshot changed the parser\n");
+        return 1;
+    }
+
+    // snapshot whose rows count doesn't fit in int (it would become negative) is rejected
+    uint32_t huge_rows_count = 0x80000001;
+    FILE * huge_file = cp_auto.saveSnapshot("huge.snapshot") ? fopen("huge.snapshot", "r+b") : 0;
+    bool patched = huge_file && fseek(huge_file, 12 /* offset of rows_count in the snapshot header */, SEEK_SET) == 0 && 
+                   fwrite(&huge_rows_count, sizeof(huge_rows_count), 1, huge_file) == 1;
+    if (huge_file)
+        fclose(huge_file);
+    CSV_Parser cp_huge(/*format*/ "aL");
+    loaded = patched && cp_huge.loadSnapshot("huge.snapshot");
+    remove("huge.snapshot");
+    cp_huge << "big,n\n5,1\n";
+    if (!patched || loaded || cp_huge.getRowsCount() != 1 || ((uint8_t*)cp_huge[0])[0] != 5) {
+        printf("Error: snapshot with too many rows was loaded\n");
+        return 1;
+    }
+
+    // separate parsers used by separate threads at the same time don't affect each other
+    const char * crlf_csv = "id,text\r\n"
+                            "1,\"a,\r\nb\"\r\n"
+                            "2,\"\"\"quoted\"\"\"\r\n"
+                            "3,plain\r\n"
+                            "4,\"\"\r\n"
+                            "5,last";
+    CSV_Parser cp_crlf(crlf_csv, /*format*/ "Ls");
+    cp_crlf.parseLeftover();
+    std::vector<std::thread> threads;
+    bool threads_ok[8];
+    for (int t = 0; t < 8; t++) {
+        threads_ok[t] = true;
+        threads.emplace_back(parseInChunks, crlf_csv, (size_t)(t + 1), &cp_crlf, &threads_ok[t]);
+    }
+    for (int t = 0; t < 8; t++)
+        threads[t].join();
+    for (int t = 0; t < 8; t++) {
+        if (!threads_ok[t]) {
+            printf("Error: parser used by a thread gave different values (%d-char chunks)\n", t + 1);
+            return 1;
+        }
+    }
     return 0;
 }
\ No newline at end of file